@@ -24,20 +24,30 @@
 #include "branch.hpp"
 #include "constants.hpp"
 #include "leaf.hpp"
+#include "tree_context.hpp"
+#include "tube_mesh.hpp"
+#include "cone_cache.hpp"
+#include "change_counter.hpp"
+#include "tree_material.hpp"
+#include "leaf_budget.hpp"
+#include "branch_budget.hpp"
+#include "lifecycle_scheduler.hpp"
 
 // Qt include.
 #include <Qt3DCore/QTransform>
 #include <Qt3DExtras/QConeMesh>
-#include <Qt3DExtras/QPhongMaterial>
-#include <Qt3DRender/QMesh>
+#include <Qt3DRender/QGeometryRenderer>
 
 #include <QList>
+#include <QPointer>
 #include <QtMath>
 
 // C++ include.
 #include <random>
 #include <cmath>
 #include <memory>
+#include <list>
+#include <limits>
 
 
 //
@@ -63,6 +73,37 @@ struct LeafData Q_DECL_FINAL {
 }; // struct LeafData
 
 
+//
+// Segment
+//
+
+//! Continuation branch merged into the branch.
+struct Segment Q_DECL_FINAL {
+	//! Start length.
+	float m_length;
+	//! Age of the segment is less than age of the branch by this delta.
+	float m_ageDelta;
+	//! Is this a first branch.
+	bool m_firstBranch;
+	//! Current length with scale.
+	float m_scaledLength;
+	//! End pos. Children of the segment are placed here.
+	QVector3D m_endPos;
+}; // struct Segment
+
+
+//! Age of the continuation chain when it's merged into the parent.
+static const float c_consolidationAge = 3.0f;
+
+//! Age of the branch the last leafs fall at.
+static const float c_deepAutumn = 0.96f;
+
+//! Start pos of the branch in the coordinates of its top entity.
+static const QVector3D c_localStartPos( 0.0f, -1.0f, 0.0f );
+//! End pos of the branch in the coordinates of its top entity.
+static const QVector3D c_localEndPos( 0.0f, 0.0f, 0.0f );
+
+
 //
 // BranchPrivate
 //
@@ -72,34 +113,48 @@ public:
 	BranchPrivate( const QVector3D & startParentPos,
 		const QVector3D & endParentPos, quint16 & age,
 		float parentRadius, bool continuation, bool isTree,
-		Qt3DExtras::QPhongMaterial * material,
-		Qt3DRender::QMesh * leafMesh,
-		QTimer * animationTimer,
+		TreeContext * context,
 		Branch * parent, Branch * parentBranch,
-		bool firstBranch, quint64 & entityCounter,
-		bool useInstanceRendering, bool enableDeath )
+		bool firstBranch )
 		:	m_mesh( Q_NULLPTR )
 		,	m_transform( Q_NULLPTR )
-		,	m_material( material )
+		,	m_tube( Q_NULLPTR )
+		,	m_tubeEntity( Q_NULLPTR )
+		,	m_meshEntity( Q_NULLPTR )
+		,	m_meshTransform( Q_NULLPTR )
+		,	m_top( Q_NULLPTR )
+		,	m_topTransform( Q_NULLPTR )
+		,	m_tree( parentBranch ? parentBranch->d->m_tree : parent->parentEntity() )
+		,	m_material( Q_NULLPTR )
+		,	m_context( context )
 		,	m_length( 0.0f )
-		,	m_startParentPos( startParentPos )
-		,	m_endParentPos( endParentPos )
+		,	m_meshLength( 0.0f )
+		,	m_scale( 1.0f )
+		,	m_bottomRadius( 0.0f )
+		,	m_topRadius( 0.0f )
+		,	m_birthAge( parentBranch ? parentBranch->d->m_birthAge +
+				parentBranch->d->topAgeDelta() : 0.0f )
+		,	m_year( -1 )
+		,	m_ageDelta( 1.0f )
+		,	m_startParentPos( &startParentPos )
+		,	m_endParentPos( &endParentPos )
 		,	m_treeAge( age )
 		,	m_age( 0 )
+		,	m_currentAge( 0.0f )
+		,	m_summerAge( -1.0f )
+		,	m_wantedLeafs( 0 )
 		,	m_parentRadius( parentRadius )
 		,	m_continuation( continuation )
 		,	m_isTree( isTree )
-		,	m_startPos( endParentPos )
-		,	m_leafMesh( leafMesh )
-		,	m_animationTimer( animationTimer )
+		,	m_startPos( &endParentPos )
 		,	m_firstBranch( firstBranch )
-		,	m_useInstanceRendering( useInstanceRendering )
-		,	m_enableDeath( enableDeath )
 		,	m_parentBranch( parentBranch )
 		,	q( parent )
-		,	m_entityCounter( entityCounter )
 	{
-		++m_entityCounter;
+		++( *m_context->m_entityCounter );
+
+		if( m_context->m_branchBudget )
+			m_context->m_branchBudget->addBranch( q );
 	}
 
 	~BranchPrivate()
@@ -114,30 +169,126 @@ public:
 
 		m_leafs.clear();
 
-		--m_entityCounter;
+		delete m_tubeEntity;
+
+		if( m_mesh )
+			m_context->m_coneCache->release( m_mesh );
+
+		--( *m_context->m_entityCounter );
+
+		if( m_context->m_branchBudget )
+			m_context->m_branchBudget->removeBranch();
+
+		// Events of the branch and its leafs don't wait in the queue.
+		if( m_context->m_scheduler )
+			m_context->m_scheduler->cancel( q );
 	}
 
 	//! Init.
 	void init();
+	//! Create leafs.
+	void createLeafs( quint8 count );
+	//! Schedule death of the branch.
+	void scheduleDeath();
+	//! Schedule autumn color and fall of the leaf.
+	void scheduleLeaf( Leaf * leaf );
+	//! \return Leaf data of the leaf, null if the leaf isn't on the branch.
+	LeafData * leafData( Leaf * leaf );
 	//! Place on top of parent and make parallel to the parent.
 	void placeOnTopAndParallel();
-
-	//! Mesh.
+	//! \return Scale of the branch of the given summer age.
+	float scaleOf( float summerAge ) const;
+	//! \return Length of the branch of the given summer age, without scale.
+	float lengthOf( float length, bool firstBranch, float summerAge ) const;
+	//! Apply growth of the given age to the transform and mesh.
+	void grow( float age );
+	//! Merge old continuation child into this branch.
+	void consolidate();
+	//! Merge continuation child into this branch.
+	void merge( Branch * child );
+	//! Move children anchored at the given position to the new one.
+	void reanchor( const QList< Branch* > & children,
+		const QVector3D * from, const QVector3D * to );
+	//! \return Age delta of children spawned on top of the branch.
+	float topAgeDelta() const;
+	//! \return Direction of the parent in the coordinates of the branch.
+	QVector3D parentDirection() const;
+	//! \return Entity the mesh and the material are attached to.
+	Qt3DCore::QEntity * meshEntity() const;
+	//! \return Parent entity of children and leafs.
+	Qt3DCore::QEntity * topEntity() const;
+	//! \return End pos in the coordinates of the tree.
+	QVector3D treeEndPos() const;
+	//! Apply growth at the start of the year, the rest is done by the shader.
+	void growOnGpu( float age );
+	//! Apply spring growth to the leaf.
+	void growLeaf( const LeafData & leaf, float age );
+	//! Update leafs which seasons are evaluated by the shader.
+	void updateGpuLeafs( float age );
+	//! \return Continuation child.
+	Branch * continuationChild() const;
+	//! Rebuild tube of the continuation chain started by this branch.
+	void updateTube();
+
+	//! Shared mesh of the unit length, null if tubes are used.
 	Qt3DExtras::QConeMesh * m_mesh;
 	//! Transform.
 	Qt3DCore::QTransform * m_transform;
-	//! Material.
-	Qt3DExtras::QPhongMaterial * m_material;
+	//! Tube of the continuation chain, only on the first branch of the chain.
+	TubeMesh * m_tube;
+	//! Entity of the tube. It's a child of the tree, so it may die first.
+	QPointer< Qt3DCore::QEntity > m_tubeEntity;
+	//! Entity of the mesh in the hierarchy of entities, it keeps the
+	//! scale away from children.
+	Qt3DCore::QEntity * m_meshEntity;
+	//! Transform of the mesh in the hierarchy of entities.
+	Qt3DCore::QTransform * m_meshTransform;
+	//! Top of the branch in the hierarchy of entities, parent of children
+	//! and leafs.
+	Qt3DCore::QEntity * m_top;
+	//! Transform of the top in the hierarchy of entities.
+	Qt3DCore::QTransform * m_topTransform;
+	//! Tree entity.
+	Qt3DCore::QEntity * m_tree;
+	//! Own material if growth is evaluated by the shader.
+	TreeMaterial * m_material;
+	//! Tree context.
+	TreeContext * m_context;
 	//! Start length.
 	float m_length;
+	//! Current length of the branch, without scale.
+	float m_meshLength;
+	//! Current scale.
+	float m_scale;
+	//! Bottom radius, without scale.
+	float m_bottomRadius;
+	//! Top radius, without scale.
+	float m_topRadius;
+	//! Age of the tree when the branch was born.
+	float m_birthAge;
+	//! Year the transform was grown for on GPU growth.
+	int m_year;
+	//! Top position at the start of the spring on GPU growth.
+	QVector3D m_springTop;
+	//! Age of the branch is less than age of the parent by this delta.
+	float m_ageDelta;
+	//! Merged continuation segments, the first one is the branch itself.
+	//! Empty if nothing is merged.
+	std::list< Segment > m_segments;
 	//! Start parent pos.
-	const QVector3D & m_startParentPos;
+	const QVector3D * m_startParentPos;
 	//! End parent pos.
-	const QVector3D & m_endParentPos;
+	const QVector3D * m_endParentPos;
 	//! Age of the tree.
 	quint16 & m_treeAge;
 	//! Age of the branch.
 	quint16 m_age;
+	//! Current age of the branch.
+	float m_currentAge;
+	//! Summer age the transform was grown for.
+	float m_summerAge;
+	//! Count of leafs the branch waits for in the leaf budget.
+	quint8 m_wantedLeafs;
 	//! Parent radius.
 	float m_parentRadius;
 	//! Is this branch a continuation of the parent?
@@ -145,103 +296,250 @@ public:
 	//! Is it a tree?
 	bool m_isTree;
 	//! Start pos.
-	const QVector3D & m_startPos;
+	const QVector3D * m_startPos;
 	//! End pos.
 	QVector3D m_endPos;
 	//! Leafs.
 	QList< LeafData > m_leafs;
 	//! Child branches.
 	QList< Branch* > m_children;
-	//! Leaf mesh.
-	Qt3DRender::QMesh * m_leafMesh;
-	//! Animation timer.
-	QTimer * m_animationTimer;
 	//! Is this a first branch.
 	bool m_firstBranch;
-	//! Use instance rendering?
-	bool m_useInstanceRendering;
-	//! Enable death?
-	bool m_enableDeath;
 	//! Real parent.
 	Branch * m_parentBranch;
 	//! Parent.
 	Branch * q;
-	//! Entity counter.
-	quint64 & m_entityCounter;
 }; // class BranchPrivate
 
 void
 BranchPrivate::init()
 {
-	auto coneMesh = std::make_unique< Qt3DExtras::QConeMesh > ();
-
-	std::random_device rd;
-	std::mt19937 gen( rd() );
+	const auto & policy = m_context->m_policy;
+	auto & gen = m_context->m_generator;
 	std::uniform_real_distribution< float > ldis( 0.0f,
-		c_branchLengthDistortion );
+		policy.branchLengthDistortion() );
 
-	std::uniform_real_distribution< float > rdis( 0.0f, c_branchDistortion );
+	std::uniform_real_distribution< float > rdis( 0.0f,
+		policy.branchDistortion() );
 
 	if( m_continuation )
-		coneMesh->setBottomRadius( m_parentRadius );
+		m_bottomRadius = m_parentRadius;
 	else
-		coneMesh->setBottomRadius( m_parentRadius - rdis( gen ) );
+		m_bottomRadius = m_parentRadius - rdis( gen );
+
+	m_topRadius = m_bottomRadius - policy.branchRadiusDelta();
 
-	coneMesh->setTopRadius( coneMesh->bottomRadius() - c_branchRadiusDelta );
+	m_length = policy.branchLength() + ( m_firstBranch ? 0.0f : ldis( gen ) );
 
-	coneMesh->setHasBottomEndcap( true );
-	coneMesh->setHasTopEndcap( true );
+	m_meshLength = m_length;
 
-	m_length = c_branchLength + ( m_firstBranch ? 0.0f : ldis( gen ) );
+	if( m_context->m_useHierarchy )
+	{
+		// Scale of the mesh mustn't be inherited by children, so the mesh
+		// and the top are siblings under the branch.
+		m_meshEntity = new Qt3DCore::QEntity( q );
+		m_meshTransform = new Qt3DCore::QTransform( m_meshEntity );
+		m_meshEntity->addComponent( m_meshTransform );
+
+		m_top = new Qt3DCore::QEntity( q );
+		m_topTransform = new Qt3DCore::QTransform( m_top );
+		m_top->addComponent( m_topTransform );
+	}
 
-	coneMesh->setLength( m_length );
+	if( m_context->m_useTubes )
+	{
+		// Continuation chain is drawn by the tube of its first branch.
+		if( !m_continuation )
+		{
+			m_tubeEntity = new Qt3DCore::QEntity( q->parentEntity() );
 
-	coneMesh->setRings( 20 );
-	coneMesh->setSlices( 10 );
+			m_tube = new TubeMesh( m_tubeEntity );
+			m_tube->setSlices( m_context->m_quality.m_slices );
 
-	m_mesh = coneMesh.get();
+			m_tubeEntity->addComponent( m_tube );
+			m_tubeEntity->addComponent( m_context->m_material );
+		}
+	}
+	else
+	{
+		// Length is applied by the transform, so branches with close
+		// radii share one mesh.
+		m_mesh = m_context->m_coneCache->acquire( m_bottomRadius, m_topRadius,
+			m_context->m_quality.m_rings, m_context->m_quality.m_slices );
 
-	q->addComponent( coneMesh.release() );
+		meshEntity()->addComponent( m_mesh );
+	}
 
 	auto transform = std::make_unique< Qt3DCore::QTransform > ();
 
-	transform->setTranslation( m_endParentPos );
+	// In the hierarchy children are placed on top of the parent by Qt3D.
+	transform->setTranslation( m_top && m_parentBranch ?
+		QVector3D() : *m_endParentPos );
+
+	if( !m_top )
+		transform->setScale3D( QVector3D( 1.0f, m_meshLength, 1.0f ) );
 
-	m_endPos = m_startPos + QVector3D( 0.0f, m_mesh->length(), 0.0f );
+	m_endPos = *m_startPos + QVector3D( 0.0f, m_meshLength, 0.0f );
 
 	m_transform = transform.get();
 
 	q->addComponent( transform.release() );
 
-	q->addComponent( m_material );
+	if( m_mesh )
+	{
+		if( m_context->m_gpuGrowth )
+		{
+			auto material = std::make_unique< TreeMaterial > ( m_context->m_effect );
+			material->setDiffuse( m_context->m_material->diffuse() );
+			material->setGrowth( m_birthAge, m_length,
+				m_firstBranch ? TreeMaterial::FirstTrunkGrowth :
+				m_isTree ? TreeMaterial::TrunkGrowth :
+				TreeMaterial::BranchGrowth );
+
+			m_material = material.get();
+
+			meshEntity()->addComponent( material.release() );
+		}
+		else
+			meshEntity()->addComponent( m_context->m_material );
+	}
+
+	if( m_context->m_changeCounter )
+	{
+		m_context->m_changeCounter->watch( q );
+		m_context->m_changeCounter->watch( meshEntity() );
+		m_context->m_changeCounter->watch( m_top );
+		m_context->m_changeCounter->watch( m_tubeEntity.data() );
+	}
 
 	// If this branch is continuation branch then place it on top and parallel.
 	if( m_continuation )
 		placeOnTopAndParallel();
 
-	if( m_useInstanceRendering )
-		m_leafMesh->setInstanceCount( m_leafMesh->instanceCount() +
-			c_leafsCount );
+	scheduleDeath();
 
-	// Create leafs.
-	for( quint8 i = 0; i < c_leafsCount; ++i )
+	const quint8 leafsCount = qMin( policy.leafsCount(),
+		m_context->m_quality.m_leafsCount );
+
+	// With the budget leafs are created later, if the branch deserves them.
+	if( m_context->m_leafBudget && m_context->m_leafBudget->limit() > 0 )
 	{
-		m_leafs.push_back( LeafData( new Leaf( m_startPos, m_endPos,
-			m_leafMesh, m_animationTimer, q, m_entityCounter,
-			q->parentEntity(), m_useInstanceRendering ) ) );
+		m_wantedLeafs = leafsCount;
+
+		m_context->m_leafBudget->enqueue( q );
+	}
+	else
+		createLeafs( leafsCount );
+}
+
+void
+BranchPrivate::createLeafs( quint8 count )
+{
+	if( m_context->m_useInstanceRendering )
+		m_context->m_leafMesh->setInstanceCount(
+			m_context->m_leafMesh->instanceCount() + count );
+
+	for( quint8 i = 0; i < count; ++i )
+	{
+		// In the hierarchy leafs are children of the top of the branch.
+		if( m_top )
+		{
+			m_leafs.push_back( LeafData( new Leaf( c_localStartPos,
+				c_localEndPos, m_context, q, m_top ) ) );
+			m_leafs.last().m_leaf->setEnabled( !m_context->m_leafsParent ||
+				m_context->m_leafsParent->isEnabled() );
+		}
+		else
+			m_leafs.push_back( LeafData( new Leaf( *m_startPos, m_endPos,
+				m_context, q, ( m_context->m_leafsParent ?
+					m_context->m_leafsParent : q->parentEntity() ) ) ) );
+
 		m_leafs.last().m_leaf->updatePosition();
 		m_leafs.last().m_leaf->setAge( 0.0f );
 
+		if( m_context->m_gpuSeasons )
+			m_leafs.last().m_leaf->setSeason( m_birthAge );
+		else
+			scheduleLeaf( m_leafs.last().m_leaf );
+
 		QObject::connect( m_leafs.last().m_leaf, &Leaf::nodeDestroyed,
 			q, &Branch::leafDeleted );
 	}
 }
 
+void
+BranchPrivate::scheduleDeath()
+{
+	if( !m_context->m_scheduler || !m_context->m_enableDeath || m_isTree )
+		return;
+
+	const auto & policy = m_context->m_policy;
+	auto & gen = m_context->m_generator;
+
+	// Branch dies when sample of N( 0.0, 0.5 ) >= death probability, it's
+	// rolled every tick while rounded age is in ( 1, min ) or ( max, inf ).
+	// Count of failed rolls is geometric, so the age is sampled at once.
+	const double p = 0.5 * std::erfc( policy.deathProbability() /
+		( 0.5 * std::sqrt( 2.0 ) ) );
+
+	if( p <= 0.0 )
+		return;
+
+	std::uniform_real_distribution< double > dis( 0.0, 1.0 );
+
+	const double failed = ( p >= 1.0 ? 0.0 :
+		std::floor( std::log( 1.0 - dis( gen ) ) / std::log1p( -p ) ) );
+
+	if( failed >= (double) std::numeric_limits< float >::max() )
+		return;
+
+	const float rolling = (float) ( ( failed + 1.0 ) /
+		(double) m_context->m_ticksPerYear );
+	const float young = qMax( 0.0f,
+		(float) policy.minDeathThreeshold() - 0.5f - 1.5f );
+
+	const float age = ( rolling <= young ? 1.5f + rolling :
+		qMax( 1.5f, (float) policy.maxDeathThreeshold() + 0.5f ) +
+			rolling - young );
+
+	m_context->m_scheduler->schedule( age - m_currentAge,
+		LifecycleEvent::BranchDeath, q );
+}
+
+void
+BranchPrivate::scheduleLeaf( Leaf * leaf )
+{
+	// Leafs born after the first year of the branch live forever.
+	if( !m_context->m_scheduler || m_currentAge >= 1.0f )
+		return;
+
+	// The same rolls as they were done every tick.
+	m_context->m_scheduler->schedule(
+		Leaf::turnAge( m_currentAge, m_context ) - m_currentAge,
+		LifecycleEvent::LeafTurn, q, leaf );
+
+	// Leafs left after the deep autumn fall all at once.
+	m_context->m_scheduler->schedule(
+		Leaf::fallAge( m_currentAge, m_context ) - m_currentAge,
+		LifecycleEvent::LeafFall, q, leaf );
+}
+
+LeafData *
+BranchPrivate::leafData( Leaf * leaf )
+{
+	for( auto & l : m_leafs )
+	{
+		if( l.m_leaf == leaf )
+			return &l;
+	}
+
+	return Q_NULLPTR;
+}
+
 void
 BranchPrivate::placeOnTopAndParallel()
 {
-	const QVector3D parent = ( m_endParentPos - m_startParentPos )
-		.normalized();
+	const QVector3D parent = parentDirection();
 	const QVector3D b = QVector3D( 0.0f, 1.0f, 0.0f ).normalized();
 
 	const QVector3D axis = QVector3D::crossProduct( parent, b );
@@ -256,6 +554,358 @@ BranchPrivate::placeOnTopAndParallel()
 	q->updatePosition();
 }
 
+//! \return Summer age, branches grow in the spring only.
+static inline float summerAgeOf( float age )
+{
+	float tmp = age;
+	float i = 0.0f;
+
+	for( ; tmp >= 1.0f; tmp -= 1.0f )
+		i += 1.0f;
+
+	if( tmp <= 0.25f )
+		tmp *= 4.0f;
+	else
+		tmp = 1.0f;
+
+	return i + tmp;
+}
+
+float
+BranchPrivate::scaleOf( float summerAge ) const
+{
+	return ( summerAge <= 1.0 ? summerAge :
+		 1.0f + summerAge / ( 100.0f / m_context->m_policy.branchScale() ) );
+}
+
+float
+BranchPrivate::lengthOf( float length, bool firstBranch, float summerAge ) const
+{
+	const auto & policy = m_context->m_policy;
+
+	return length +
+		length * summerAge / ( 100.0f / policy.branchLengthMultiplicator() ) /
+		// Tree trunk grows faster, branches grow slower.
+		( !m_isTree ? policy.branchSlower() : 1.0f ) *
+		// First tree trunk branch grows even faster.
+		( firstBranch ? policy.firstBranchGrowsFaster() : 1.0f );
+}
+
+void
+BranchPrivate::grow( float age )
+{
+	const float summerAge = summerAgeOf( age );
+
+	m_summerAge = summerAge;
+	m_scale = scaleOf( summerAge );
+
+	m_meshLength = lengthOf( m_length, m_firstBranch, summerAge );
+
+	// Merged segments grow each at its own age, the mesh is stretched
+	// to the whole length.
+	float total = 0.0f;
+
+	if( !m_segments.empty() )
+	{
+		for( auto & s : m_segments )
+		{
+			const float segmentAge = summerAgeOf( qMax( 0.0f,
+				age - s.m_ageDelta ) );
+
+			s.m_scaledLength = scaleOf( segmentAge ) *
+				lengthOf( s.m_length, s.m_firstBranch, segmentAge );
+
+			total += s.m_scaledLength;
+		}
+
+		m_meshLength = total / m_scale;
+	}
+
+	if( m_top )
+	{
+		// Children and leafs follow the top without updates on the CPU.
+		const float length = m_scale * m_meshLength;
+
+		m_meshTransform->setScale3D( QVector3D( m_scale, length, m_scale ) );
+		m_meshTransform->setTranslation( QVector3D( 0.0f, length / 2.0f, 0.0f ) );
+		m_topTransform->setTranslation( QVector3D( 0.0f, length, 0.0f ) );
+
+		return;
+	}
+
+	m_transform->setScale3D( QVector3D( m_scale, m_scale * m_meshLength,
+		m_scale ) );
+
+	q->updatePosition();
+
+	if( !m_segments.empty() )
+	{
+		float length = 0.0f;
+
+		for( auto it = m_segments.begin(), last = std::prev( m_segments.end() );
+			it != last; ++it )
+		{
+			length += it->m_scaledLength;
+
+			it->m_endPos = m_transform->matrix().map(
+				QVector3D( 0.0f, length / total - 0.5f, 0.0f ) );
+		}
+	}
+}
+
+void
+BranchPrivate::consolidate()
+{
+	Branch * child = continuationChild();
+
+	if( child && child->d->m_currentAge >= c_consolidationAge &&
+		!child->d->m_material && child->d->m_leafs.isEmpty() &&
+		!child->wantedLeafsCount() )
+	{
+		merge( child );
+
+		grow( m_currentAge );
+	}
+}
+
+void
+BranchPrivate::reanchor( const QList< Branch* > & children,
+	const QVector3D * from, const QVector3D * to )
+{
+	for( const auto & b : children )
+	{
+		if( b->d->m_endParentPos == from )
+		{
+			b->d->m_startParentPos = m_startPos;
+			b->d->m_endParentPos = to;
+			b->d->m_startPos = to;
+
+			// Leafs keep the address of the start of the branch.
+			for( const auto & l : qAsConst( b->d->m_leafs ) )
+				l.m_leaf->reanchor( from, to );
+		}
+	}
+}
+
+void
+BranchPrivate::merge( Branch * child )
+{
+	auto * c = child->d.get();
+
+	if( m_segments.empty() )
+		m_segments.push_back( { m_length, 0.0f, m_firstBranch, 0.0f, m_endPos } );
+
+	if( c->m_segments.empty() )
+		c->m_segments.push_back( { c->m_length, 0.0f, c->m_firstBranch, 0.0f,
+			c->m_endPos } );
+
+	// Top of the branch becomes a joint.
+	m_children.removeOne( child );
+
+	reanchor( m_children, &m_endPos, &m_segments.back().m_endPos );
+
+	// Top of the child becomes top of the branch.
+	reanchor( c->m_children, &c->m_endPos, &m_endPos );
+
+	for( auto & s : c->m_segments )
+		s.m_ageDelta += c->m_ageDelta;
+
+	// Nodes are moved, so joints keep their addresses.
+	m_segments.splice( m_segments.end(), c->m_segments );
+
+	for( const auto & b : qAsConst( c->m_children ) )
+	{
+		b->d->m_ageDelta += c->m_ageDelta;
+		b->d->m_parentBranch = q;
+
+		QObject::disconnect( b, &Branch::nodeDestroyed,
+			child, &Branch::childBranchDeleted );
+		QObject::connect( b, &Branch::nodeDestroyed,
+			q, &Branch::childBranchDeleted );
+	}
+
+	m_children.append( c->m_children );
+	c->m_children.clear();
+
+	m_topRadius = c->m_topRadius * c->m_scale / m_scale;
+
+	if( m_mesh )
+	{
+		auto * mesh = m_context->m_coneCache->acquire( m_bottomRadius,
+			m_topRadius, m_context->m_quality.m_rings,
+			m_context->m_quality.m_slices );
+
+		meshEntity()->removeComponent( m_mesh );
+		m_context->m_coneCache->release( m_mesh );
+
+		m_mesh = mesh;
+		meshEntity()->addComponent( m_mesh );
+
+		if( m_context->m_changeCounter )
+			m_context->m_changeCounter->watch( m_mesh );
+	}
+
+	QObject::disconnect( child, &Branch::nodeDestroyed,
+		q, &Branch::childBranchDeleted );
+
+	delete child;
+}
+
+QVector3D
+BranchPrivate::parentDirection() const
+{
+	if( m_top && m_parentBranch )
+		return QVector3D( 0.0f, 1.0f, 0.0f );
+	else
+		return ( *m_endParentPos - *m_startParentPos ).normalized();
+}
+
+Qt3DCore::QEntity *
+BranchPrivate::meshEntity() const
+{
+	return ( m_meshEntity ? m_meshEntity : q );
+}
+
+Qt3DCore::QEntity *
+BranchPrivate::topEntity() const
+{
+	return ( m_top ? m_top : q->parentEntity() );
+}
+
+QVector3D
+BranchPrivate::treeEndPos() const
+{
+	return ( m_top ? q->topMatrix().map( QVector3D() ) : m_endPos );
+}
+
+float
+BranchPrivate::topAgeDelta() const
+{
+	return 1.0f + ( m_segments.empty() ? 0.0f : m_segments.back().m_ageDelta );
+}
+
+void
+BranchPrivate::growOnGpu( float age )
+{
+	const float year = std::floor( age );
+
+	if( (int) year == m_year )
+		return;
+
+	m_year = (int) year;
+
+	grow( year );
+
+	const QVector3D top = m_endPos - *m_startPos;
+
+	// Transform keeps the end of the spring till the next year.
+	grow( year + 0.25f );
+
+	// Parent is grown for this year already, it's on the stack of setAge().
+	const QVector3D bottom = ( m_parentBranch ?
+		m_parentBranch->d->m_springTop : *m_startPos );
+
+	m_springTop = bottom + top;
+
+	m_material->setSpringOffset( bottom - *m_startPos );
+
+	// Leafs are on the branch in the first year only.
+	if( m_year == 0 )
+	{
+		for( const auto & l : qAsConst( m_leafs ) )
+		{
+			if( !l.m_deleted )
+				l.m_leaf->setSpringOffset( m_springTop - m_endPos );
+		}
+	}
+}
+
+void
+BranchPrivate::growLeaf( const LeafData & leaf, float age )
+{
+	// Spring.
+	if( age <= 0.25f )
+		leaf.m_leaf->setAge( age * 4.0f );
+
+	leaf.m_leaf->updatePosition();
+}
+
+void
+BranchPrivate::updateGpuLeafs( float age )
+{
+	// Leafs follow the branch grown on the CPU.
+	if( age <= 0.5f && !m_material )
+	{
+		for( const auto & l : qAsConst( m_leafs ) )
+			l.m_leaf->updatePosition();
+	}
+	// Leafs have fallen in the shader a year ago at least.
+	else if( age >= 2.0f && !m_leafs.isEmpty() )
+	{
+		if( m_context->m_useInstanceRendering )
+			m_context->m_leafMesh->setInstanceCount(
+				m_context->m_leafMesh->instanceCount() - m_leafs.size() );
+
+		const auto leafs = m_leafs;
+
+		m_leafs.clear();
+
+		for( const auto & l : leafs )
+			delete l.m_leaf;
+	}
+}
+
+Branch *
+BranchPrivate::continuationChild() const
+{
+	for( const auto & b : qAsConst( m_children ) )
+	{
+		if( b->d->m_continuation )
+			return b;
+	}
+
+	return Q_NULLPTR;
+}
+
+void
+BranchPrivate::updateTube()
+{
+	QVector< TubeRing > rings;
+
+	for( const Branch * b = q; b; b = b->d->continuationChild() )
+	{
+		const float scale = b->d->m_scale;
+		const float bottom = b->d->m_bottomRadius * scale;
+
+		// Joint ring is shared by both segments.
+		if( rings.isEmpty() )
+			rings.append( { b->startPos(), bottom } );
+		else
+			rings.last().m_radius = ( rings.last().m_radius + bottom ) / 2.0f;
+
+		// Joints of merged segments.
+		if( !b->d->m_segments.empty() )
+		{
+			const float top = b->d->m_topRadius * scale;
+			const float length = b->length();
+			float current = 0.0f;
+
+			for( auto it = b->d->m_segments.cbegin(),
+				last = std::prev( b->d->m_segments.cend() ); it != last; ++it )
+			{
+				current += it->m_scaledLength;
+
+				rings.append( { it->m_endPos,
+					bottom + ( top - bottom ) * current / length } );
+			}
+		}
+
+		rings.append( { b->endPos(), b->d->m_topRadius * scale } );
+	}
+
+	m_tube->setRings( rings );
+}
+
 
 //
 // Branch
@@ -264,20 +914,14 @@ BranchPrivate::placeOnTopAndParallel()
 Branch::Branch( const QVector3D & startParentPos,
 	const QVector3D & endParentPos, quint16 & age,
 	float parentRadius, bool continuation, bool isTree,
-	Qt3DExtras::QPhongMaterial * material,
-	Qt3DRender::QMesh * leafMesh,
-	QTimer * animationTimer,
+	TreeContext * context,
 	Branch * parentBranch,
-	quint64 & entityCounter,
 	Qt3DCore::QEntity * parent,
-	bool firstBranch,
-	bool useInstanceRendering,
-	bool enableDeath )
+	bool firstBranch )
 	:	Qt3DCore::QEntity( parent )
 	,	d( new BranchPrivate( startParentPos, endParentPos, age,
-			parentRadius, continuation, isTree, material,
-			leafMesh, animationTimer, this, parentBranch,
-			firstBranch, entityCounter, useInstanceRendering, enableDeath ) )
+			parentRadius, continuation, isTree, context,
+			this, parentBranch, firstBranch ) )
 {
 	d->init();
 }
@@ -289,8 +933,7 @@ Branch::~Branch()
 void
 Branch::rotate( float angle )
 {
-	const QVector3D parent = ( d->m_endParentPos - d->m_startParentPos )
-		.normalized();
+	const QVector3D parent = d->parentDirection();
 	const QVector3D b( 0.0f, 1.0f, 0.0f );
 
 	QVector3D axis = QVector3D::crossProduct( b, parent ).normalized();
@@ -300,9 +943,9 @@ Branch::rotate( float angle )
 
 	const float cosAngle = QVector3D::dotProduct( b, parent );
 
-	std::random_device rd;
-	std::mt19937 gen( rd() );
-	std::uniform_real_distribution< float > dis( 0.0f, c_maxBranchAngle );
+	auto & gen = d->m_context->m_generator;
+	std::uniform_real_distribution< float > dis( 0.0f,
+		d->m_context->m_policy.maxBranchAngle() );
 
 	const float plainAngle = qRadiansToDegrees( std::acos( cosAngle ) ) + 90.0f
 		- dis( gen );
@@ -317,86 +960,29 @@ void
 Branch::setAge( float age )
 {
 	d->m_age = static_cast< quint16 > ( qRound( age ) );
+	d->m_currentAge = age;
 
-	float tmp = age;
-	float i = 0.0f;
-
-	for( ; tmp >= 1.0f; tmp -= 1.0f )
-		i += 1.0f;
-
-	if( tmp <= 0.25f )
-		tmp *= 4.0f;
+	if( d->m_material )
+		d->growOnGpu( age );
 	else
-		tmp = 1.0f;
-
-	const float summerAge = i + tmp;
-
-	static const float c_deepAutumn = 0.96f;
-
-	d->m_transform->setScale( summerAge <= 1.0 ? summerAge :
-		 1.0f + summerAge / ( 100.0f / c_branchScale ) );
+		d->grow( age );
 
-	d->m_mesh->setLength( d->m_length +
-		d->m_length * summerAge / ( 100.0f / c_branchLengthMultiplicator ) /
-		// Tree trunk grows faster, branches grow slower.
-		( !d->m_isTree ? c_branchSlower : 1.0f ) *
-		// First tree trunk branch grows even faster.
-		( d->m_firstBranch ? c_firstBranchGrowsFaster : 1.0f ) );
-
-	updatePosition();
+	if( d->m_context->m_consolidateChains )
+		d->consolidate();
 
-	if( age < 1.0f )
+	// Autumn color and fall of leafs are fired by the lifecycle scheduler.
+	if( d->m_context->m_gpuSeasons )
+		d->updateGpuLeafs( age );
+	else if( age < 1.0f )
 	{
-		for( auto it = d->m_leafs.begin(), last = d->m_leafs.end();
-			it != last; ++it )
+		// Spring and summer.
+		if( age <= 0.5f )
 		{
-			// Spring.
-			if( age <= 0.25f )
-			{
-				(*it).m_leaf->setAge( age * 4.0f );
-				(*it).m_leaf->updatePosition();
-			}
-			else if( age > 0.25f && age <= 0.5f )
-				(*it).m_leaf->updatePosition();
-			// Autumn.
-			else if( age > 0.5f && age <= 0.75f )
-			{
-				if( !(*it).m_autumn )
-				{
-					std::random_device rd;
-					std::mt19937 gen( rd() );
-					std::uniform_real_distribution< float > autumn( age,
-						0.75f );
-
-					if( autumn( gen ) > 0.63f )
-					{
-						(*it).m_leaf->setColor( Leaf::autumnColor() );
-
-						(*it).m_autumn = true;
-					}
-				}
-			}
-			// Deep autumn.
-			else if( age > 0.75f )
-			{
-				if( !(*it).m_deleted )
-				{
-					std::random_device rd;
-					std::mt19937 gen( rd() );
-					std::uniform_real_distribution< float > autumn( age,
-						0.97f );
-
-					if( autumn( gen ) > c_deepAutumn )
-					{
-						(*it).m_leaf->fallAndDie();
-
-						(*it).m_deleted = true;
-					}
-				}
-			}
+			for( const auto & l : qAsConst( d->m_leafs ) )
+				d->growLeaf( l, age );
 		}
 
-		if( age > c_deepAutumn )
+		if( age > c_deepAutumn && !d->m_leafs.isEmpty() )
 		{
 			for( auto it = d->m_leafs.begin(), last = d->m_leafs.end();
 				it != last; ++it )
@@ -414,19 +1000,22 @@ Branch::setAge( float age )
 		auto tmp = d->m_children;
 
 		for( const auto & b : qAsConst( tmp ) )
-			b->setAge( age - 1.0f );
+			b->setAge( age - b->d->m_ageDelta );
 	}
-	else if( age >= 1.0f )
+	// Children grow on the top segment of the merged branch.
+	else if( age - d->topAgeDelta() >= 0.0f )
 	{
-		if( c_hasContinuationBranch )
+		const auto & policy = d->m_context->m_policy;
+		const float ageDelta = d->topAgeDelta();
+
+		if( policy.hasContinuationBranch() )
 		{
 			d->m_children.push_back( new Branch( startPos(),
 				endPos(), d->m_treeAge,
-				topRadius(), true, d->m_isTree, d->m_material,
-				d->m_leafMesh, d->m_animationTimer, this, d->m_entityCounter,
-				parentEntity(), false, d->m_useInstanceRendering,
-				d->m_enableDeath ) );
+				topRadius(), true, d->m_isTree, d->m_context,
+				this, d->topEntity() ) );
 
+			d->m_children.last()->d->m_ageDelta = ageDelta;
 			d->m_children.last()->updatePosition();
 			d->m_children.last()->placeLeafs();
 			d->m_children.last()->setAge( 0.0f );
@@ -435,13 +1024,12 @@ Branch::setAge( float age )
 				this, &Branch::childBranchDeleted );
 		}
 
-		const quint8 count = c_childBranchesCount -
-			( c_hasContinuationBranch ? 1 : 0 );
+		const quint8 count = policy.childBranchesCount() -
+			( policy.hasContinuationBranch() ? 1 : 0 );
 
-		std::random_device rd;
-		std::mt19937 gen( rd() );
+		auto & gen = d->m_context->m_generator;
 		std::uniform_real_distribution< float > dis( 0.0f,
-			c_branchRotationDistortion );
+			policy.branchRotationDistortion() );
 
 		float angle = dis( gen );
 
@@ -449,10 +1037,8 @@ Branch::setAge( float age )
 		{
 			d->m_children.push_back( new Branch( startPos(),
 				endPos(), d->m_treeAge, topRadius(), false, false,
-				d->m_material, d->m_leafMesh,
-				d->m_animationTimer, this, d->m_entityCounter,
-				parentEntity(), false, d->m_useInstanceRendering,
-				d->m_enableDeath ) );
+				d->m_context, this, d->topEntity() ) );
+			d->m_children.last()->d->m_ageDelta = ageDelta;
 			d->m_children.last()->rotate( angle );
 			d->m_children.last()->updatePosition();
 			d->m_children.last()->placeLeafs();
@@ -465,44 +1051,93 @@ Branch::setAge( float age )
 		}
 	}
 
-	// Death.
-	if( d->m_enableDeath && d->m_age > 1 )
+}
+
+void
+Branch::lifecycleEvent( LifecycleEvent::Type type, Leaf * leaf )
+{
+	switch( type )
 	{
-		if( d->m_age < c_minDeathThreeshold || d->m_age > c_maxDeathThreeshold )
+		case LifecycleEvent::BranchDeath :
+		{
+			for( const auto * b : qAsConst( d->m_children ) )
+				delete b;
+
+			d->m_children.clear();
+
+			deleteLater();
+		}
+			break;
+
+		case LifecycleEvent::LeafTurn :
 		{
-			std::random_device rd;
-			std::mt19937 gen( rd() );
-			std::normal_distribution< float > dis( 0.0f, 0.5f );
+			auto * l = d->leafData( leaf );
 
-			if( !d->m_isTree )
+			if( l && !l->m_autumn && !l->m_deleted )
 			{
-				auto v = dis( gen );
+				l->m_leaf->setColor( Leaf::autumnColor(
+					d->m_context->m_generator ) );
+
+				l->m_autumn = true;
+			}
+		}
+			break;
 
-				if( v >= c_deathProbability )
-				{
-					for( const auto * b : qAsConst( d->m_children ) )
-						delete b;
+		case LifecycleEvent::LeafFall :
+		{
+			auto * l = d->leafData( leaf );
 
-					d->m_children.clear();
+			if( l && !l->m_deleted )
+			{
+				l->m_leaf->fallAndDie();
 
-					deleteLater();
-				}
+				l->m_deleted = true;
 			}
 		}
+			break;
+	}
+}
+
+void
+Branch::interpolate( float age )
+{
+	if( age < 0.0f )
+		age = 0.0f;
+
+	// Shader interpolates growth itself. Branches grow in the spring only,
+	// the rest of the year the transform is the same.
+	if( !d->m_material && summerAgeOf( age ) != d->m_summerAge )
+		d->grow( age );
+
+	if( age <= 0.5f && !d->m_material )
+	{
+		for( const auto & l : qAsConst( d->m_leafs ) )
+		{
+			if( !l.m_deleted )
+				d->growLeaf( l, age );
+		}
 	}
+
+	for( const auto & b : qAsConst( d->m_children ) )
+		b->interpolate( age - b->d->m_ageDelta );
 }
 
 void
 Branch::updatePosition()
 {
-	d->m_transform->setTranslation( d->m_endParentPos );
+	// Qt3D places the branch on top of the parent.
+	if( d->m_top )
+		return;
 
-	QVector3D end = QVector3D( 0.0f, d->m_mesh->length() / 2.0f, 0.0f );
+	d->m_transform->setTranslation( *d->m_endParentPos );
+
+	// Length of the branch is in the scale of the transform.
+	QVector3D end = QVector3D( 0.0f, 0.5f, 0.0f );
 	end = d->m_transform->matrix().map( end );
 
 	d->m_transform->setTranslation( end );
 
-	const QVector3D tmp( 0.0f, d->m_mesh->length() / 2.0f, 0.0f );
+	const QVector3D tmp( 0.0f, 0.5f, 0.0f );
 
 	d->m_endPos = d->m_transform->matrix().map( tmp );
 }
@@ -510,27 +1145,26 @@ Branch::updatePosition()
 void
 Branch::placeLeafs()
 {
-	std::random_device rd;
-	std::mt19937 gen( rd() );
+	auto & gen = d->m_context->m_generator;
 	std::uniform_real_distribution< float > rotdis( 0.0f,
-		c_leafRotationDistortion );
+		d->m_context->m_policy.leafRotationDistortion() );
 
 	float startLeafAngle = rotdis( gen );
 
-	for( quint8 i = 0; i < c_leafsCount; ++i )
+	for( const auto & l : qAsConst( d->m_leafs ) )
 	{
-		d->m_leafs.at( i ).m_leaf->rotate( startLeafAngle );
-		d->m_leafs.at( i ).m_leaf->updatePosition();
-		d->m_leafs.at( i ).m_leaf->setAge( 0.0f );
+		l.m_leaf->rotate( startLeafAngle );
+		l.m_leaf->updatePosition();
+		l.m_leaf->setAge( 0.0f );
 
-		startLeafAngle += 360.0f / (float) c_leafsCount;
+		startLeafAngle += 360.0f / (float) d->m_leafs.size();
 	}
 }
 
 const QVector3D &
 Branch::startPos() const
 {
-	return d->m_startPos;
+	return *d->m_startPos;
 }
 
 const QVector3D &
@@ -542,13 +1176,197 @@ Branch::endPos() const
 float
 Branch::topRadius() const
 {
-	return d->m_mesh->topRadius() * d->m_transform->scale();
+	return d->m_topRadius * d->m_scale;
 }
 
 float
 Branch::length() const
 {
-	return d->m_mesh->length() * d->m_transform->scale();
+	return d->m_meshLength * d->m_scale;
+}
+
+quint8
+Branch::wantedLeafsCount() const
+{
+	// Leafs born in the autumn make no sense.
+	return ( d->m_currentAge <= 0.5f ? d->m_wantedLeafs : 0 );
+}
+
+float
+Branch::leafsPriority() const
+{
+	// Outer branches of the crown: far from the trunk and high.
+	const QVector3D end = d->treeEndPos();
+
+	float priority = 1.0f + std::hypot( end.x(), end.z() ) +
+		0.25f * qMax( 0.0f, end.y() );
+
+	// Terminal branches aren't buried in the crown.
+	if( d->m_children.isEmpty() )
+		priority *= 2.0f;
+
+	const bool visible = d->m_tree->isEnabled() &&
+		( !d->m_context->m_leafsParent ||
+			d->m_context->m_leafsParent->isEnabled() );
+
+	if( visible )
+		priority *= 4.0f;
+
+	return priority;
+}
+
+void
+Branch::createLeafs( quint8 count )
+{
+	d->m_wantedLeafs = 0;
+
+	d->createLeafs( count );
+
+	placeLeafs();
+
+	// Catch up with the spring.
+	for( const auto & l : qAsConst( d->m_leafs ) )
+	{
+		l.m_leaf->setAge( d->m_currentAge * 4.0f );
+
+		if( d->m_material && d->m_year == 0 )
+			l.m_leaf->setSpringOffset( d->m_springTop - d->m_endPos );
+	}
+}
+
+bool
+Branch::isTrunk() const
+{
+	return d->m_isTree;
+}
+
+const QList< Branch* > &
+Branch::childBranches() const
+{
+	return d->m_children;
+}
+
+float
+Branch::pruningPriority() const
+{
+	// Young shoots outside and on top of the crown are kept, old branches
+	// inside and below, shaded by the crown, go first.
+	const QVector3D end = d->treeEndPos();
+
+	return ( 1.0f + std::hypot( end.x(), end.z() ) +
+		0.5f * qMax( 0.0f, end.y() ) ) / ( 1.0f + d->m_age );
+}
+
+QMatrix4x4
+Branch::topMatrix() const
+{
+	QMatrix4x4 m;
+
+	if( d->m_top )
+	{
+		if( d->m_parentBranch )
+			m = d->m_parentBranch->topMatrix();
+
+		m *= d->m_transform->matrix();
+		m *= d->m_topTransform->matrix();
+	}
+	else
+	{
+		m.translate( d->m_endPos );
+		m.rotate( d->m_transform->rotation() );
+	}
+
+	return m;
+}
+
+QMatrix4x4
+Branch::meshMatrix() const
+{
+	if( d->m_top )
+	{
+		QMatrix4x4 m;
+
+		if( d->m_parentBranch )
+			m = d->m_parentBranch->topMatrix();
+
+		return m * d->m_transform->matrix() * d->m_meshTransform->matrix();
+	}
+	else
+		return d->m_transform->matrix();
+}
+
+float
+Branch::meshBottomRadius() const
+{
+	return d->m_bottomRadius;
+}
+
+float
+Branch::meshTopRadius() const
+{
+	return d->m_topRadius;
+}
+
+QList< Leaf* >
+Branch::leafs() const
+{
+	QList< Leaf* > res;
+
+	for( const auto & l : qAsConst( d->m_leafs ) )
+	{
+		if( !l.m_deleted )
+			res.append( l.m_leaf );
+	}
+
+	return res;
+}
+
+void
+Branch::setLeafsEnabled( bool on )
+{
+	for( const auto & l : qAsConst( d->m_leafs ) )
+	{
+		if( !l.m_deleted )
+			l.m_leaf->setEnabled( on );
+	}
+
+	for( const auto & b : qAsConst( d->m_children ) )
+		b->setLeafsEnabled( on );
+}
+
+void
+Branch::setTessellation( int rings, int slices )
+{
+	if( d->m_mesh )
+	{
+		auto * mesh = d->m_context->m_coneCache->acquire( d->m_bottomRadius,
+			d->m_topRadius, rings, slices );
+
+		d->meshEntity()->removeComponent( d->m_mesh );
+		d->m_context->m_coneCache->release( d->m_mesh );
+
+		d->m_mesh = mesh;
+		d->meshEntity()->addComponent( d->m_mesh );
+
+		if( d->m_context->m_changeCounter )
+			d->m_context->m_changeCounter->watch( d->m_mesh );
+	}
+
+	if( d->m_tube )
+		d->m_tube->setSlices( slices );
+
+	for( const auto & b : qAsConst( d->m_children ) )
+		b->setTessellation( rings, slices );
+}
+
+void
+Branch::updateTubes()
+{
+	if( d->m_tube )
+		d->updateTube();
+
+	for( const auto & b : qAsConst( d->m_children ) )
+		b->updateTubes();
 }
 
 void
@@ -23,28 +23,18 @@
 #ifndef TREE__BRANCH_HPP__INCLUDED
 #define TREE__BRANCH_HPP__INCLUDED
 
+// 3Dtree include.
+#include "lifecycle_scheduler.hpp"
+
 // Qt include.
 #include <Qt3DCore/QEntity>
+#include <QMatrix4x4>
 
 // C++ include.
 #include <memory>
 
-QT_BEGIN_NAMESPACE
-
-namespace Qt3DExtras {
-	class QPhongMaterial;
-}
-
-namespace Qt3DRender {
-	class QMesh;
-}
-
-class QTimer;
-
-QT_END_NAMESPACE
-
-
 class Leaf;
+struct TreeContext;
 
 
 //
@@ -62,15 +52,10 @@ public:
 		const QVector3D & endParentPos,
 		quint16 & age,
 		float parentRadius, bool continuation, bool isTree,
-		Qt3DExtras::QPhongMaterial * material,
-		Qt3DRender::QMesh * leafMesh,
-		QTimer * animationTimer,
+		TreeContext * context,
 		Branch * parentBranch,
-		quint64 & entityCounter,
 		Qt3DCore::QEntity * parent = Q_NULLPTR,
-		bool firstBranch = false,
-		bool useInstanceRendering = false,
-		bool enableDeath = true );
+		bool firstBranch = false );
 	~Branch();
 
 	//! Rotate on top of the parent.
@@ -79,6 +64,11 @@ public:
 	//! Set age of the branch. 1.0f = 1 year, 2.0f = 2 years, and so on.
 	void setAge( float age );
 
+	//! Apply growth of the given age without simulation, i.e. without
+	//! spawning, death and leaf fall. Used to interpolate between
+	//! simulation steps.
+	void interpolate( float age );
+
 	//! Update position.
 	void updatePosition();
 
@@ -94,6 +84,55 @@ public:
 	//! \return Length.
 	float length() const;
 
+	//! Set tessellation of the branch and all its children.
+	void setTessellation( int rings, int slices );
+
+	//! Rebuild tubes of continuation chains of the branch and all its
+	//! children. Used if tubes are enabled in the context.
+	void updateTubes();
+
+	//! \return Count of leafs the branch waits for in the leaf budget.
+	quint8 wantedLeafsCount() const;
+
+	//! \return Priority of the branch in the leaf budget.
+	float leafsPriority() const;
+
+	//! Create leafs given by the leaf budget.
+	void createLeafs( quint8 count );
+
+	//! \return Is it a branch of the trunk?
+	bool isTrunk() const;
+
+	//! \return Child branches.
+	const QList< Branch* > & childBranches() const;
+
+	//! \return Priority of the branch in the branch budget.
+	float pruningPriority() const;
+
+	//! \return Matrix of the top of the branch in the coordinates of the tree.
+	QMatrix4x4 topMatrix() const;
+
+	//! \return Matrix of the mesh in the coordinates of the tree. The mesh
+	//! is a cone of the unit length along Y centered at the origin with
+	//! meshBottomRadius() and meshTopRadius().
+	QMatrix4x4 meshMatrix() const;
+
+	//! \return Bottom radius of the mesh, without scale.
+	float meshBottomRadius() const;
+
+	//! \return Top radius of the mesh, without scale.
+	float meshTopRadius() const;
+
+	//! \return Leafs on the branch, falling leafs aren't included.
+	QList< Leaf* > leafs() const;
+
+	//! Enable/disable leafs of the branch and all its children. Used with
+	//! the hierarchy of entities, where leafs are children of branches.
+	void setLeafsEnabled( bool on );
+
+	//! Handle due event of the lifecycle scheduler.
+	void lifecycleEvent( LifecycleEvent::Type type, Leaf * leaf );
+
 private slots:
 	//! Delete child from the list. This is not real deletion.
 	void childBranchDeleted();
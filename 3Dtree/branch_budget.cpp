@@ -0,0 +1,190 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "branch_budget.hpp"
+#include "branch.hpp"
+#include "tree.hpp"
+
+// C++ include.
+#include <algorithm>
+#include <cmath>
+
+
+//
+// BranchBudget
+//
+
+BranchBudget::BranchBudget()
+	:	m_limit( 0 )
+	,	m_count( 0 )
+	,	m_year( -1 )
+	,	m_order( 0 )
+{
+}
+
+BranchBudget::~BranchBudget()
+{
+}
+
+int
+BranchBudget::limit() const
+{
+	return m_limit;
+}
+
+void
+BranchBudget::setLimit( int limit )
+{
+	m_limit = qMax( 0, limit );
+
+	// Unlimited budget keeps no candidates, limited one collects them
+	// from the trees on the next pruning.
+	m_heap.clear();
+	m_born.clear();
+	m_year = -1;
+}
+
+int
+BranchBudget::count() const
+{
+	return m_count;
+}
+
+void
+BranchBudget::addBranch( Branch * b )
+{
+	++m_count;
+
+	// Priority isn't known till the branch is placed.
+	if( b && m_limit > 0 && m_year >= 0 )
+		m_born.append( b );
+}
+
+void
+BranchBudget::removeBranch()
+{
+	--m_count;
+}
+
+//! Heap order, candidate with the lowest priority and the earliest order
+//! is on the top.
+template< typename T >
+static inline bool pruneLater( const T & a, const T & b )
+{
+	return ( a.m_priority > b.m_priority ||
+		( a.m_priority == b.m_priority && a.m_order > b.m_order ) );
+}
+
+void
+BranchBudget::push( Branch * b )
+{
+	if( b->isTrunk() )
+		return;
+
+	m_heap.push_back( { b->pruningPriority(), m_order++, b } );
+
+	std::push_heap( m_heap.begin(), m_heap.end(), pruneLater< Candidate > );
+}
+
+//! Collect branches that may be pruned.
+template< typename Push >
+static inline void collect( Branch * b, Push & push )
+{
+	push( b );
+
+	for( const auto & c : b->childBranches() )
+		collect( c, push );
+}
+
+void
+BranchBudget::rebuild( const QVector< Tree* > & trees )
+{
+	m_heap.clear();
+	m_born.clear();
+	m_order = 0;
+
+	auto append = [this] ( Branch * b )
+	{
+		if( !b->isTrunk() )
+			m_heap.push_back( { b->pruningPriority(), m_order++, b } );
+	};
+
+	// Trees grown by an engine have no branches.
+	for( const auto & t : trees )
+	{
+		if( t->rootBranch() )
+			collect( t->rootBranch(), append );
+	}
+
+	std::make_heap( m_heap.begin(), m_heap.end(), pruneLater< Candidate > );
+}
+
+int
+BranchBudget::prune( const QVector< Tree* > & trees, float age )
+{
+	if( m_limit == 0 )
+		return 0;
+
+	const int year = static_cast< int > ( std::floor( age ) );
+
+	if( year != m_year )
+	{
+		// Branches grow once a year, so do priorities.
+		rebuild( trees );
+
+		m_year = year;
+	}
+	else if( !m_born.isEmpty() )
+	{
+		for( const auto & b : qAsConst( m_born ) )
+		{
+			if( b )
+				push( b.data() );
+		}
+
+		m_born.clear();
+	}
+
+	int pruned = 0;
+
+	while( m_count > m_limit && !m_heap.empty() )
+	{
+		std::pop_heap( m_heap.begin(), m_heap.end(), pruneLater< Candidate > );
+
+		const QPointer< Branch > b = m_heap.back().m_branch;
+
+		m_heap.pop_back();
+
+		// Could be pruned with the parent already.
+		if( b )
+		{
+			const int before = m_count;
+
+			delete b.data();
+
+			pruned += before - m_count;
+		}
+	}
+
+	return pruned;
+}
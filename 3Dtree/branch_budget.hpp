@@ -0,0 +1,105 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__BRANCH_BUDGET_HPP__INCLUDED
+#define TREE__BRANCH_BUDGET_HPP__INCLUDED
+
+// Qt include.
+#include <QVector>
+#include <QPointer>
+
+// C++ include.
+#include <vector>
+
+class Tree;
+class Branch;
+
+
+//
+// BranchBudget
+//
+
+//! Hard cap on live branches, shared by all trees. When it's exceeded,
+//! subtrees with the lowest priority are pruned: old, low and interior
+//! branches shaded by the crown go first, young shoots outside of the
+//! crown are kept, trunks are never pruned. Pruning is deterministic,
+//! so runs with the same seed give the same trees.
+//!
+//! Candidates are kept in a heap. Priorities change only with the growth,
+//! so the heap is rebuilt once a year and branches born during the year
+//! are pushed to it, pruning pops only the branches it deletes.
+class BranchBudget Q_DECL_FINAL {
+public:
+	BranchBudget();
+	~BranchBudget();
+
+	//! \return Max count of live branches, 0 means unlimited.
+	int limit() const;
+	//! Set max count of live branches.
+	void setLimit( int limit );
+
+	//! \return Count of live branches.
+	int count() const;
+	//! Branch was created. \par b is null for nodes of growth engines,
+	//! they are counted but aren't pruned.
+	void addBranch( Branch * b );
+	//! Branch was deleted.
+	void removeBranch();
+
+	//! Prune subtrees of the trees of the given \par age till count of
+	//! branches fits the limit.
+	//! \return Count of pruned branches.
+	int prune( const QVector< Tree* > & trees, float age );
+
+private:
+	//! Candidate to pruning.
+	struct Candidate {
+		//! Priority, lower is pruned first.
+		float m_priority;
+		//! Order of insertion, for deterministic ties.
+		quint64 m_order;
+		//! Branch, null if it's deleted already.
+		QPointer< Branch > m_branch;
+	}; // struct Candidate
+
+	//! Rebuild heap of candidates from the trees.
+	void rebuild( const QVector< Tree* > & trees );
+	//! Push branch to the heap.
+	void push( Branch * b );
+
+	//! Heap of candidates, candidate with the lowest priority on the top.
+	std::vector< Candidate > m_heap;
+	//! Branches born since the last rebuild of the heap.
+	QVector< QPointer< Branch > > m_born;
+	//! Year the heap was built for, -1 if it should be rebuilt.
+	int m_year;
+	//! Order of the next candidate.
+	quint64 m_order;
+	//! Max count of live branches.
+	int m_limit;
+	//! Count of live branches.
+	int m_count;
+
+	Q_DISABLE_COPY( BranchBudget )
+}; // class BranchBudget
+
+#endif // TREE__BRANCH_BUDGET_HPP__INCLUDED
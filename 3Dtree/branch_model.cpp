@@ -0,0 +1,72 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "branch_model.hpp"
+
+
+//
+// BranchModelEngine
+//
+
+BranchModelEngine::BranchModelEngine( quint32 seed,
+	const GrowthPolicy & policy, bool enableDeath, int ticksPerYear )
+	:	m_model( seed, enableDeath, ticksPerYear, policy )
+	,	m_generation( 0 )
+{
+}
+
+void
+BranchModelEngine::grow( int generation )
+{
+	if( generation <= m_generation )
+		return;
+
+	m_generation = generation;
+
+	// Generation is requested at the start of the year it grows in.
+	const float year = (float) ( generation - 1 );
+
+	if( year > m_model.age() )
+		m_model.setAge( year );
+
+	const float spring = year + 0.25f;
+	const auto & nodes = m_model.nodes();
+
+	m_nodes = nodes;
+
+	for( size_t i = 0; i < nodes.size(); ++i )
+	{
+		const float age = qMax( 0.0f, spring - nodes[ i ].m_birth );
+		const float scale = m_model.scale( age );
+
+		m_nodes[ i ].m_length = m_model.length( nodes[ i ], age );
+		m_nodes[ i ].m_bottomRadius *= scale;
+		m_nodes[ i ].m_topRadius *= scale;
+	}
+}
+
+const std::vector< GrowthNode > &
+BranchModelEngine::nodes() const
+{
+	return m_nodes;
+}
@@ -0,0 +1,57 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__BRANCH_MODEL_HPP__INCLUDED
+#define TREE__BRANCH_MODEL_HPP__INCLUDED
+
+// 3Dtree include.
+#include "growth_engine.hpp"
+
+
+//
+// BranchModelEngine
+//
+
+//! Grows the headless GrowthModel, i.e. the same rules as Branch, without
+//! Qt3D nodes, so it runs on the simulation thread. Nodes are published
+//! with lengths and radii of the end of the spring of the generation.
+class BranchModelEngine Q_DECL_FINAL
+	:	public GrowthEngine
+{
+public:
+	BranchModelEngine( quint32 seed, const GrowthPolicy & policy,
+		bool enableDeath, int ticksPerYear );
+
+	void grow( int generation ) Q_DECL_OVERRIDE;
+
+	const std::vector< GrowthNode > & nodes() const Q_DECL_OVERRIDE;
+
+private:
+	//! Model.
+	BasicGrowthModel< GrowthPolicy > m_model;
+	//! Nodes with lengths and radii of the current generation.
+	std::vector< GrowthNode > m_nodes;
+	//! Generation.
+	int m_generation;
+}; // class BranchModelEngine
+
+#endif // TREE__BRANCH_MODEL_HPP__INCLUDED
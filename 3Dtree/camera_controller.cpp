@@ -55,6 +55,7 @@ public:
 		,	m_mouseDevice( new Qt3DInput::QMouseDevice( parent ) )
 		,	m_logicalDevice( new Qt3DInput::QLogicalDevice )
 		,	m_frameAction( new Qt3DLogic::QFrameAction )
+		,	m_frameActionComponent( Q_NULLPTR )
 		,	q( parent )
 	{
 	}
@@ -82,6 +83,8 @@ public:
 	std::unique_ptr< Qt3DInput::QLogicalDevice > m_logicalDevice;
 	//! Frame action.
 	std::unique_ptr< Qt3DLogic::QFrameAction > m_frameAction;
+	//! Frame action, enabled only while camera rotates.
+	Qt3DLogic::QFrameAction * m_frameActionComponent;
 	//! Parent.
 	CameraController * q;
 }; // class CameraControllerPrivate
@@ -109,6 +112,15 @@ CameraControllerPrivate::init()
 
 	QObject::connect( m_frameAction.get(), &Qt3DLogic::QFrameAction::triggered,
 		q, &CameraController::_q_onTriggered );
+	QObject::connect( m_leftMouseButtonAction, &Qt3DInput::QAction::activeChanged,
+		q, &CameraController::_q_onRotationChanged );
+	QObject::connect( m_tzAxis, &Qt3DInput::QAxis::valueChanged,
+		q, &CameraController::_q_onZoom );
+
+	// Nothing to do per frame until the camera rotates.
+	m_frameAction->setEnabled( false );
+
+	m_frameActionComponent = m_frameAction.get();
 
 	q->addComponent( m_frameAction.release() );
 	q->addComponent( m_logicalDevice.release() );
@@ -140,12 +152,21 @@ CameraController::_q_onTriggered( float )
 			Qt3DCore::QTransform::fromAxisAndAngle( 0.0f, 1.0f, 0.0f,
 				- d->m_rxAxis->value() ) );
 	}
-	else
-	{
-		const float z = d->m_tzAxis->value();
+}
 
-		if( d->m_camera->position().length() > 15.0 || z < 0.0f )
-			d->m_camera->translate( QVector3D( 0.0f, 0.0f, z ),
-				Qt3DRender::QCamera::DontTranslateViewCenter );
-	}
+void
+CameraController::_q_onRotationChanged( bool active )
+{
+	d->m_frameActionComponent->setEnabled( active );
+}
+
+void
+CameraController::_q_onZoom( float z )
+{
+	if( d->m_leftMouseButtonAction->isActive() )
+		return;
+
+	if( d->m_camera->position().length() > 15.0 || z < 0.0f )
+		d->m_camera->translate( QVector3D( 0.0f, 0.0f, z ),
+			Qt3DRender::QCamera::DontTranslateViewCenter );
 }
@@ -56,6 +56,10 @@ public:
 
 private slots:
 	void _q_onTriggered( float );
+	//! Left mouse button pressed or released.
+	void _q_onRotationChanged( bool active );
+	//! Mouse wheel moved.
+	void _q_onZoom( float z );
 
 private:
 	friend class CameraControllerPrivate;
@@ -0,0 +1,273 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "change_counter.hpp"
+
+// Qt include.
+#include <QMetaProperty>
+#include <QJsonArray>
+
+#include <Qt3DCore/QEntity>
+#include <Qt3DCore/QTransform>
+#include <Qt3DCore/QGeometry>
+#include <Qt3DCore/QAttribute>
+#include <Qt3DCore/QBuffer>
+#include <Qt3DRender/QMaterial>
+#include <Qt3DRender/QParameter>
+#include <Qt3DRender/QGeometryRenderer>
+
+// C++ include.
+#include <algorithm>
+
+
+//
+// ChangeCounter
+//
+
+ChangeCounter::ChangeCounter( QObject * parent )
+	:	QObject( parent )
+	,	m_recentTicks( 0 )
+	,	m_totalTicks( 0 )
+{
+}
+
+ChangeCounter::~ChangeCounter()
+{
+}
+
+void
+ChangeCounter::watch( QObject * node )
+{
+	if( !node )
+		return;
+
+	watchNode( node );
+
+	// Only the node and its own components are watched, child entities
+	// are watched by their owners when they are created.
+	auto * entity = qobject_cast< Qt3DCore::QEntity* > ( node );
+
+	if( entity )
+	{
+		const auto components = entity->components();
+
+		for( const auto & c : components )
+			watchComponent( c );
+	}
+	else
+		watchComponent( node );
+}
+
+void
+ChangeCounter::watchComponent( QObject * component )
+{
+	watchNode( component );
+
+	auto * material = qobject_cast< Qt3DRender::QMaterial* > ( component );
+
+	if( material )
+	{
+		const auto parameters = material->parameters();
+
+		for( const auto & p : parameters )
+			watchNode( p );
+
+		return;
+	}
+
+	auto * renderer = qobject_cast< Qt3DRender::QGeometryRenderer* > (
+		component );
+
+	if( renderer && renderer->geometry() )
+	{
+		watchNode( renderer->geometry() );
+
+		const auto attributes = renderer->geometry()->attributes();
+
+		for( const auto & a : attributes )
+		{
+			watchNode( a );
+
+			if( a->buffer() )
+				watchNode( a->buffer() );
+		}
+	}
+}
+
+void
+ChangeCounter::watchNode( QObject * node )
+{
+	if( m_watched.contains( node ) )
+		return;
+
+	m_watched.insert( node );
+
+	connect( node, &QObject::destroyed, this, &ChangeCounter::nodeDestroyed );
+
+	const QMetaObject * meta = node->metaObject();
+
+	if( !m_signals.contains( meta ) )
+	{
+		QHash< int, int > & indexes = m_signals[ meta ];
+
+		// Matrix of the transform notifies together with translation,
+		// rotation and scale.
+		const bool transform = meta->inherits(
+			&Qt3DCore::QTransform::staticMetaObject );
+
+		auto add = [&] ( const QMetaMethod & signal, const char * name )
+		{
+			indexes.insert( signal.methodIndex(), m_entries.size() );
+
+			m_entries.append( { QString::fromLatin1( meta->className() )
+				.section( QLatin1String( "::" ), -1 ) +
+				QLatin1String( "::" ) + QLatin1String( name ), 0, 0,
+				transform && qstrcmp( name, "matrix" ) == 0 } );
+		};
+
+		for( int i = QObject::staticMetaObject.propertyCount();
+			i < meta->propertyCount(); ++i )
+		{
+			const QMetaProperty p = meta->property( i );
+
+			if( p.isWritable() && p.hasNotifySignal() )
+				add( p.notifySignal(), p.name() );
+		}
+
+		const int dataChanged = meta->indexOfSignal( "dataChanged(QByteArray)" );
+
+		if( dataChanged >= 0 && !indexes.contains( dataChanged ) )
+			add( meta->method( dataChanged ), "data" );
+	}
+
+	const QMetaMethod slot = staticMetaObject.method(
+		staticMetaObject.indexOfSlot( "changed()" ) );
+
+	for( auto it = m_signals[ meta ].cbegin(), last = m_signals[ meta ].cend();
+		it != last; ++it )
+			connect( node, meta->method( it.key() ), this, slot );
+}
+
+void
+ChangeCounter::tick()
+{
+	++m_recentTicks;
+	++m_totalTicks;
+}
+
+QVector< ChangeCounter::Entry >
+ChangeCounter::snapshot( int * ticks )
+{
+	QVector< Entry > res;
+
+	for( auto & e : m_entries )
+	{
+		if( e.m_recent > 0 )
+			res.append( e );
+
+		e.m_recent = 0;
+	}
+
+	std::sort( res.begin(), res.end(),
+		[] ( const Entry & a, const Entry & b )
+			{ return a.m_recent > b.m_recent; } );
+
+	if( ticks )
+		*ticks = m_recentTicks;
+
+	m_recentTicks = 0;
+
+	return res;
+}
+
+QJsonObject
+ChangeCounter::toJson() const
+{
+	QJsonObject changes;
+	QJsonObject perTick;
+	QJsonArray derived;
+
+	for( const auto & e : m_entries )
+	{
+		if( e.m_total == 0 )
+			continue;
+
+		if( e.m_derived )
+			derived.append( e.m_name );
+
+		changes.insert( e.m_name, (qint64) e.m_total );
+
+		if( m_totalTicks > 0 )
+			perTick.insert( e.m_name, (double) e.m_total / (double) m_totalTicks );
+	}
+
+	QJsonObject o;
+	o.insert( QStringLiteral( "ticks" ), (qint64) m_totalTicks );
+	o.insert( QStringLiteral( "total" ), changes );
+	o.insert( QStringLiteral( "perTick" ), perTick );
+	o.insert( QStringLiteral( "derived" ), derived );
+
+	return o;
+}
+
+void
+ChangeCounter::reset()
+{
+	for( auto & e : m_entries )
+	{
+		e.m_recent = 0;
+		e.m_total = 0;
+	}
+
+	m_recentTicks = 0;
+	m_totalTicks = 0;
+}
+
+void
+ChangeCounter::changed()
+{
+	const int idx = entryIndex( sender()->metaObject(), senderSignalIndex() );
+
+	if( idx >= 0 )
+	{
+		++m_entries[ idx ].m_recent;
+		++m_entries[ idx ].m_total;
+	}
+}
+
+void
+ChangeCounter::nodeDestroyed( QObject * node )
+{
+	m_watched.remove( node );
+}
+
+int
+ChangeCounter::entryIndex( const QMetaObject * meta, int signalIndex ) const
+{
+	const auto it = m_signals.constFind( meta );
+
+	if( it == m_signals.cend() )
+		return -1;
+
+	return it->value( signalIndex, -1 );
+}
@@ -0,0 +1,117 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__CHANGE_COUNTER_HPP__INCLUDED
+#define TREE__CHANGE_COUNTER_HPP__INCLUDED
+
+// Qt include.
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QJsonObject>
+
+
+//
+// ChangeCounter
+//
+
+//! Counts property changes of Qt3D nodes, i.e. changes that are synced
+//! from frontend to backend, by node type and property.
+//!
+//! Every property change of the node emits its notify signal, so the
+//! counter listens to notify signals of writable properties and to
+//! QBuffer::dataChanged. Watching costs one connection per property, so
+//! it's enabled on demand.
+//!
+//! QTransform::matrix notifies on every change of translation, rotation
+//! or scale, so its count duplicates them and isn't an extra sync.
+class ChangeCounter Q_DECL_FINAL
+	:	public QObject
+{
+	Q_OBJECT
+
+public:
+	//! Count of changes of one property.
+	struct Entry {
+		//! Name, i.e. "QTransform::translation".
+		QString m_name;
+		//! Changes since the last snapshot.
+		quint64 m_recent;
+		//! Total count of changes.
+		quint64 m_total;
+		//! Property is derived from other watched properties, so its
+		//! changes are counted twice, i.e. QTransform::matrix.
+		bool m_derived;
+	}; // struct Entry
+
+	explicit ChangeCounter( QObject * parent = Q_NULLPTR );
+	~ChangeCounter();
+
+	//! Watch node and its own components: parameters of materials,
+	//! geometry, attributes and buffers of meshes. Child entities aren't
+	//! watched. Node is watched only once.
+	void watch( QObject * node );
+
+	//! Simulation tick is done.
+	void tick();
+
+	//! \return Entries sorted by recent changes and reset recent counters
+	//! and ticks.
+	QVector< Entry > snapshot( int * ticks = Q_NULLPTR );
+
+	//! \return Total changes and ticks as JSON. Derived properties are
+	//! listed in "derived".
+	QJsonObject toJson() const;
+
+	//! Reset all counters.
+	void reset();
+
+private slots:
+	//! Property changed.
+	void changed();
+	//! Watched node destroyed.
+	void nodeDestroyed( QObject * node );
+
+private:
+	//! Watch component with its parameters or geometry.
+	void watchComponent( QObject * component );
+	//! Watch one node.
+	void watchNode( QObject * node );
+	//! \return Index of the entry for the signal.
+	int entryIndex( const QMetaObject * meta, int signalIndex ) const;
+
+	//! Entries.
+	QVector< Entry > m_entries;
+	//! Entry index by signal index, per class.
+	QHash< const QMetaObject*, QHash< int, int > > m_signals;
+	//! Watched nodes.
+	QSet< QObject* > m_watched;
+	//! Ticks since the last snapshot.
+	int m_recentTicks;
+	//! Total ticks.
+	quint64 m_totalTicks;
+
+	Q_DISABLE_COPY( ChangeCounter )
+}; // class ChangeCounter
+
+#endif // TREE__CHANGE_COUNTER_HPP__INCLUDED
@@ -0,0 +1,104 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "cone_cache.hpp"
+
+// Qt include.
+#include <Qt3DExtras/QConeMesh>
+
+
+//! Step of radius quantization.
+static const float c_radiusQuantum = 0.0025f;
+
+
+//
+// ConeCache
+//
+
+ConeCache::ConeCache( Qt3DCore::QNode * parent )
+	:	m_parent( parent )
+{
+}
+
+ConeCache::~ConeCache()
+{
+	// Meshes are owned by the parent node.
+}
+
+Qt3DExtras::QConeMesh *
+ConeCache::acquire( float bottomRadius, float topRadius,
+	int rings, int slices )
+{
+	const ConeKey key = { qRound( bottomRadius / c_radiusQuantum ),
+		qRound( topRadius / c_radiusQuantum ), rings, slices };
+
+	auto it = m_entries.find( key );
+
+	if( it != m_entries.end() && !it->m_mesh.isNull() )
+	{
+		++it->m_refs;
+
+		return it->m_mesh.data();
+	}
+
+	auto * mesh = new Qt3DExtras::QConeMesh( m_parent.data() );
+	mesh->setBottomRadius( (float) key.m_bottomRadius * c_radiusQuantum );
+	mesh->setTopRadius( (float) key.m_topRadius * c_radiusQuantum );
+	mesh->setHasBottomEndcap( true );
+	mesh->setHasTopEndcap( true );
+	mesh->setLength( 1.0f );
+	mesh->setRings( rings );
+	mesh->setSlices( slices );
+
+	m_entries.insert( key, { mesh, 1 } );
+	m_keys.insert( mesh, key );
+
+	return mesh;
+}
+
+void
+ConeCache::release( Qt3DExtras::QConeMesh * mesh )
+{
+	auto kit = m_keys.find( mesh );
+
+	if( kit == m_keys.end() )
+		return;
+
+	auto it = m_entries.find( kit.value() );
+
+	if( --it->m_refs == 0 )
+	{
+		// Entities holding the mesh may be deleted later in this event loop.
+		if( !it->m_mesh.isNull() )
+			it->m_mesh->deleteLater();
+
+		m_entries.erase( it );
+		m_keys.erase( kit );
+	}
+}
+
+int
+ConeCache::count() const
+{
+	return m_entries.size();
+}
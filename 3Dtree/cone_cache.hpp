@@ -0,0 +1,110 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__CONE_CACHE_HPP__INCLUDED
+#define TREE__CONE_CACHE_HPP__INCLUDED
+
+// Qt include.
+#include <QHash>
+#include <QPointer>
+
+QT_BEGIN_NAMESPACE
+
+namespace Qt3DCore {
+	class QNode;
+}
+
+namespace Qt3DExtras {
+	class QConeMesh;
+}
+
+QT_END_NAMESPACE
+
+
+//
+// ConeKey
+//
+
+//! Quantized parameters of the cone.
+struct ConeKey Q_DECL_FINAL {
+	qint32 m_bottomRadius;
+	qint32 m_topRadius;
+	qint32 m_rings;
+	qint32 m_slices;
+
+	bool operator == ( const ConeKey & other ) const
+	{
+		return ( m_bottomRadius == other.m_bottomRadius &&
+			m_topRadius == other.m_topRadius &&
+			m_rings == other.m_rings &&
+			m_slices == other.m_slices );
+	}
+}; // struct ConeKey
+
+inline size_t qHash( const ConeKey & key, size_t seed = 0 )
+{
+	return qHashMulti( seed, key.m_bottomRadius, key.m_topRadius,
+		key.m_rings, key.m_slices );
+}
+
+
+//
+// ConeCache
+//
+
+//! Cache of cone meshes of the unit length shared by branches with close
+//! radii and the same tessellation. Meshes are reference counted and
+//! deleted when the last branch releases them.
+class ConeCache Q_DECL_FINAL {
+public:
+	//! Meshes will be children of the given node.
+	explicit ConeCache( Qt3DCore::QNode * parent );
+	~ConeCache();
+
+	//! \return Mesh for the given parameters, reference count is increased.
+	Qt3DExtras::QConeMesh * acquire( float bottomRadius, float topRadius,
+		int rings, int slices );
+
+	//! Release mesh, it's deleted when reference count drops to zero.
+	void release( Qt3DExtras::QConeMesh * mesh );
+
+	//! \return Count of meshes.
+	int count() const;
+
+private:
+	//! Entry of the cache.
+	struct Entry {
+		QPointer< Qt3DExtras::QConeMesh > m_mesh;
+		int m_refs;
+	}; // struct Entry
+
+	//! Parent of meshes.
+	QPointer< Qt3DCore::QNode > m_parent;
+	//! Entries.
+	QHash< ConeKey, Entry > m_entries;
+	//! Keys of meshes.
+	QHash< Qt3DExtras::QConeMesh*, ConeKey > m_keys;
+
+	Q_DISABLE_COPY( ConeCache )
+}; // class ConeCache
+
+#endif // TREE__CONE_CACHE_HPP__INCLUDED
@@ -0,0 +1,333 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "ensemble.hpp"
+
+// Qt include.
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QThreadPool>
+#include <QFile>
+#include <QTextStream>
+#include <QtConcurrent/QtConcurrentMap>
+
+// C++ include.
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+
+//
+// Distribution
+//
+
+Distribution
+Distribution::make( QVector< float > values )
+{
+	Distribution d = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+	if( values.isEmpty() )
+		return d;
+
+	std::sort( values.begin(), values.end() );
+
+	double sum = 0.0;
+
+	for( const auto & v : qAsConst( values ) )
+		sum += v;
+
+	const double mean = sum / values.size();
+
+	double var = 0.0;
+
+	for( const auto & v : qAsConst( values ) )
+		var += ( v - mean ) * ( v - mean );
+
+	auto percentile = [&values] ( float p ) -> float
+	{
+		return values.at( qRound( p * (float) ( values.size() - 1 ) ) );
+	};
+
+	d.m_mean = (float) mean;
+	d.m_stddev = (float) std::sqrt( var / values.size() );
+	d.m_min = values.first();
+	d.m_p10 = percentile( 0.1f );
+	d.m_median = percentile( 0.5f );
+	d.m_p90 = percentile( 0.9f );
+	d.m_max = values.last();
+
+	return d;
+}
+
+QJsonObject
+Distribution::toJson() const
+{
+	QJsonObject o;
+	o.insert( QStringLiteral( "mean" ), m_mean );
+	o.insert( QStringLiteral( "stddev" ), m_stddev );
+	o.insert( QStringLiteral( "min" ), m_min );
+	o.insert( QStringLiteral( "p10" ), m_p10 );
+	o.insert( QStringLiteral( "median" ), m_median );
+	o.insert( QStringLiteral( "p90" ), m_p90 );
+	o.insert( QStringLiteral( "max" ), m_max );
+
+	return o;
+}
+
+
+//
+// Ensemble
+//
+
+Ensemble::Ensemble( int seeds, int years, quint32 baseSeed, bool enableDeath )
+	:	m_seeds( seeds )
+	,	m_years( years )
+	,	m_baseSeed( baseSeed )
+	,	m_enableDeath( enableDeath )
+	,	m_threads( 0 )
+	,	m_species( DefaultSpecies::name() )
+	,	m_useRuntimePolicy( false )
+{
+}
+
+void
+Ensemble::setThreadsCount( int count )
+{
+	m_threads = count;
+}
+
+void
+Ensemble::setSpecies( const QString & name )
+{
+	m_species = name;
+	m_useRuntimePolicy = false;
+}
+
+void
+Ensemble::setPolicy( const GrowthPolicy & policy )
+{
+	m_policy = policy;
+	m_useRuntimePolicy = true;
+}
+
+template< typename Policy >
+QVector< QVector< GrowthStats > >
+Ensemble::grow( const Policy & policy ) const
+{
+	QThreadPool pool;
+
+	if( m_threads > 0 )
+		pool.setMaxThreadCount( m_threads );
+
+	QVector< quint32 > seeds;
+	seeds.reserve( m_seeds );
+
+	for( int i = 0; i < m_seeds; ++i )
+		seeds.append( m_baseSeed + (quint32) i );
+
+	const int years = m_years;
+	const bool enableDeath = m_enableDeath;
+
+	return QtConcurrent::blockingMapped( &pool, seeds,
+		[years, enableDeath, &policy] ( quint32 seed )
+		{
+			return Ensemble::simulate< Policy > ( seed, years, enableDeath,
+				policy );
+		} );
+}
+
+QVector< YearStats >
+Ensemble::run() const
+{
+	QVector< QVector< GrowthStats > > trees;
+
+	if( m_useRuntimePolicy )
+		trees = grow( m_policy );
+	else if( m_species == SparseSpecies::name() )
+		trees = grow( SparseSpecies() );
+	else if( m_species == DenseSpecies::name() )
+		trees = grow( DenseSpecies() );
+	else
+		trees = grow( DefaultSpecies() );
+
+	QVector< YearStats > res;
+	res.reserve( m_years );
+
+	for( int y = 0; y < m_years; ++y )
+	{
+		QVector< float > branches, leafs, height, crown;
+
+		for( const auto & t : trees )
+		{
+			branches.append( t.at( y ).m_branches );
+			leafs.append( t.at( y ).m_leafs );
+			height.append( t.at( y ).m_height );
+			crown.append( t.at( y ).m_crownRadius );
+		}
+
+		YearStats s;
+		s.m_year = y + 1;
+		s.m_branches = Distribution::make( branches );
+		s.m_leafs = Distribution::make( leafs );
+		s.m_height = Distribution::make( height );
+		s.m_crownRadius = Distribution::make( crown );
+
+		res.append( s );
+	}
+
+	return res;
+}
+
+QJsonObject
+Ensemble::toJson( const QVector< YearStats > & stats ) const
+{
+	QJsonArray years;
+
+	for( const auto & s : stats )
+	{
+		QJsonObject y;
+		y.insert( QStringLiteral( "year" ), s.m_year );
+		y.insert( QStringLiteral( "branches" ), s.m_branches.toJson() );
+		y.insert( QStringLiteral( "leafs" ), s.m_leafs.toJson() );
+		y.insert( QStringLiteral( "height" ), s.m_height.toJson() );
+		y.insert( QStringLiteral( "crownRadius" ), s.m_crownRadius.toJson() );
+
+		years.append( y );
+	}
+
+	QJsonObject o;
+	o.insert( QStringLiteral( "seeds" ), m_seeds );
+	o.insert( QStringLiteral( "baseSeed" ), (qint64) m_baseSeed );
+	o.insert( QStringLiteral( "enableDeath" ), m_enableDeath );
+	o.insert( QStringLiteral( "policy" ),
+		m_useRuntimePolicy ? m_policy.name() : m_species );
+	o.insert( QStringLiteral( "years" ), years );
+
+	return o;
+}
+
+
+int
+runEnsemble( int argc, char ** argv )
+{
+	QCoreApplication app( argc, argv );
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(
+		QStringLiteral( "Grows many headless trees and prints statistics." ) );
+	parser.addHelpOption();
+
+	QCommandLineOption ensemble( QStringLiteral( "ensemble" ),
+		QStringLiteral( "Count of trees to grow." ),
+		QStringLiteral( "seeds" ) );
+	QCommandLineOption years( QStringLiteral( "years" ),
+		QStringLiteral( "Years to grow, default is 5." ),
+		QStringLiteral( "years" ), QStringLiteral( "5" ) );
+	QCommandLineOption seed( QStringLiteral( "seed" ),
+		QStringLiteral( "Seed of the first tree, random by default." ),
+		QStringLiteral( "seed" ) );
+	QCommandLineOption threads( QStringLiteral( "threads" ),
+		QStringLiteral( "Count of threads, default is count of cores." ),
+		QStringLiteral( "threads" ), QStringLiteral( "0" ) );
+	QCommandLineOption noDeath( QStringLiteral( "no-death" ),
+		QStringLiteral( "Disable death of branches." ) );
+	QCommandLineOption species( QStringLiteral( "species" ),
+		QStringLiteral( "Built-in species: %1." )
+			.arg( GrowthPolicy::builtInNames().join( QStringLiteral( ", " ) ) ),
+		QStringLiteral( "name" ), DefaultSpecies::name() );
+	QCommandLineOption policy( QStringLiteral( "policy" ),
+		QStringLiteral( "JSON file with growth policy." ),
+		QStringLiteral( "file" ) );
+	QCommandLineOption output( QStringLiteral( "output" ),
+		QStringLiteral( "Output JSON file, stdout by default." ),
+		QStringLiteral( "file" ) );
+
+	parser.addOptions( { ensemble, years, seed, threads, noDeath,
+		species, policy, output } );
+	parser.process( app );
+
+	quint32 baseSeed = 0;
+
+	if( parser.isSet( seed ) )
+		baseSeed = parser.value( seed ).toUInt();
+	else
+	{
+		std::random_device rd;
+		baseSeed = rd();
+	}
+
+	Ensemble e( qMax( 1, parser.value( ensemble ).toInt() ),
+		qBound( 1, parser.value( years ).toInt(), 99 ),
+		baseSeed, !parser.isSet( noDeath ) );
+	e.setThreadsCount( parser.value( threads ).toInt() );
+
+	if( parser.isSet( policy ) )
+	{
+		GrowthPolicy p;
+		QString error;
+
+		if( !GrowthPolicy::load( parser.value( policy ), p, &error ) )
+		{
+			QTextStream( stderr ) << error << QStringLiteral( "\n" );
+
+			return 1;
+		}
+
+		e.setPolicy( p );
+	}
+	else
+	{
+		if( !GrowthPolicy::builtInNames().contains( parser.value( species ) ) )
+		{
+			QTextStream( stderr ) << QStringLiteral( "Unknown species %1\n" )
+				.arg( parser.value( species ) );
+
+			return 1;
+		}
+
+		e.setSpecies( parser.value( species ) );
+	}
+
+	const QByteArray json = QJsonDocument( e.toJson( e.run() ) ).toJson();
+
+	if( parser.isSet( output ) )
+	{
+		QFile file( parser.value( output ) );
+
+		if( !file.open( QIODevice::WriteOnly ) )
+		{
+			QTextStream( stderr ) << QStringLiteral( "Unable to open %1\n" )
+				.arg( parser.value( output ) );
+
+			return 1;
+		}
+
+		file.write( json );
+	}
+	else
+		QTextStream( stdout ) << json;
+
+	return 0;
+}
@@ -0,0 +1,149 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__ENSEMBLE_HPP__INCLUDED
+#define TREE__ENSEMBLE_HPP__INCLUDED
+
+// 3Dtree include.
+#include "growth_model.hpp"
+
+// Qt include.
+#include <QVector>
+#include <QJsonObject>
+
+
+//
+// Distribution
+//
+
+//! Distribution of the value over the ensemble.
+struct Distribution Q_DECL_FINAL {
+	float m_mean;
+	float m_stddev;
+	float m_min;
+	float m_p10;
+	float m_median;
+	float m_p90;
+	float m_max;
+
+	//! \return Distribution of the values.
+	static Distribution make( QVector< float > values );
+
+	//! \return JSON.
+	QJsonObject toJson() const;
+}; // struct Distribution
+
+
+//
+// YearStats
+//
+
+//! Statistics of the ensemble for one year.
+struct YearStats Q_DECL_FINAL {
+	int m_year;
+	Distribution m_branches;
+	Distribution m_leafs;
+	Distribution m_height;
+	Distribution m_crownRadius;
+}; // struct YearStats
+
+
+//
+// Ensemble
+//
+
+//! Grows many headless trees concurrently, one tree per task, and
+//! aggregates per year statistics.
+class Ensemble Q_DECL_FINAL {
+public:
+	Ensemble( int seeds, int years, quint32 baseSeed, bool enableDeath );
+
+	//! Set count of threads, 0 means count of cores.
+	void setThreadsCount( int count );
+
+	//! Use built-in species with compile-time constants.
+	void setSpecies( const QString & name );
+
+	//! Use policy loaded at runtime.
+	void setPolicy( const GrowthPolicy & policy );
+
+	//! Run simulation.
+	QVector< YearStats > run() const;
+
+	//! \return JSON report.
+	QJsonObject toJson( const QVector< YearStats > & stats ) const;
+
+	//! Simulate one tree. \return Statistics of every year.
+	template< typename Policy >
+	static QVector< GrowthStats > simulate( quint32 seed, int years,
+		bool enableDeath, const Policy & policy = Policy() );
+
+private:
+	//! Grow all trees with the given policy.
+	template< typename Policy >
+	QVector< QVector< GrowthStats > > grow( const Policy & policy ) const;
+
+	//! Count of seeds.
+	int m_seeds;
+	//! Years.
+	int m_years;
+	//! Base seed.
+	quint32 m_baseSeed;
+	//! Enable death?
+	bool m_enableDeath;
+	//! Threads count.
+	int m_threads;
+	//! Name of the built-in species.
+	QString m_species;
+	//! Policy loaded at runtime.
+	GrowthPolicy m_policy;
+	//! Use runtime policy?
+	bool m_useRuntimePolicy;
+}; // class Ensemble
+
+template< typename Policy >
+QVector< GrowthStats >
+Ensemble::simulate( quint32 seed, int years, bool enableDeath,
+	const Policy & policy )
+{
+	QVector< GrowthStats > res;
+	res.reserve( years );
+
+	BasicGrowthModel< Policy > model( seed, enableDeath, 600, policy );
+
+	for( int y = 0; y < years; ++y )
+	{
+		// Measure in the summer, when leafs are on the tree.
+		model.setAge( (float) y + 0.5f );
+		model.evaluate();
+
+		res.append( model.stats() );
+	}
+
+	return res;
+}
+
+
+//! Run ensemble from the command line. \return Exit code.
+int runEnsemble( int argc, char ** argv );
+
+#endif // TREE__ENSEMBLE_HPP__INCLUDED
@@ -0,0 +1,264 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "forest.hpp"
+#include "tree.hpp"
+#include "tree_context.hpp"
+
+// Qt include.
+#include <Qt3DCore/QEntity>
+
+#include <QVector4D>
+#include <QtMath>
+
+// C++ include.
+#include <random>
+#include <cmath>
+
+
+//! Distance between trees in the grid.
+static const float c_forestSpacing = 8.0f;
+//! Size of the cell of the spatial grid.
+static const float c_forestCellSize = 32.0f;
+//! Radius of the tree's bounding sphere.
+static const float c_forestTreeRadius = 8.0f;
+//! Height of the center of the tree's bounding sphere.
+static const float c_forestTreeCenter = 5.0f;
+//! Leafs are hidden in the cells farther than this distance.
+static const float c_forestLeafsDistance = 80.0f;
+
+
+//
+// Forest
+//
+
+Forest::Forest()
+	:	m_visibleTrees( 0 )
+{
+}
+
+Forest::~Forest()
+{
+}
+
+void
+Forest::create( int count, Placement placement, quint32 seed,
+	const TreeContext & context, Qt3DCore::QEntity * parent )
+{
+	clear();
+
+	const int side = qCeil( std::sqrt( (float) count ) );
+	const float half = (float) ( side - 1 ) * c_forestSpacing / 2.0f;
+
+	std::mt19937 gen( seed );
+	std::uniform_real_distribution< float > dis( -half - c_forestSpacing / 2.0f,
+		half + c_forestSpacing / 2.0f );
+
+	m_trees.reserve( count );
+
+	for( int i = 0; i < count; ++i )
+	{
+		QVector3D pos;
+
+		if( count > 1 )
+		{
+			switch( placement )
+			{
+				case Grid :
+					pos = QVector3D( (float) ( i % side ) * c_forestSpacing - half,
+						0.0f, (float) ( i / side ) * c_forestSpacing - half );
+				break;
+
+				case Scatter :
+					pos = QVector3D( dis( gen ), 0.0f, dis( gen ) );
+				break;
+			}
+		}
+
+		m_trees.append( new Tree( context, seed + (quint32) i, pos, parent ) );
+	}
+
+	buildGrid();
+}
+
+void
+Forest::clear()
+{
+	for( const auto & t : qAsConst( m_trees ) )
+		t->deleteLater();
+
+	m_trees.clear();
+	m_cells.clear();
+
+	m_visibleTrees = 0;
+}
+
+bool
+Forest::isEmpty() const
+{
+	return m_trees.isEmpty();
+}
+
+const QVector< Tree* > &
+Forest::trees() const
+{
+	return m_trees;
+}
+
+void
+Forest::setAge( float age )
+{
+	for( const auto & t : qAsConst( m_trees ) )
+		t->setAge( age );
+}
+
+void
+Forest::interpolate( float age )
+{
+	for( const auto & c : qAsConst( m_cells ) )
+	{
+		if( c.m_visible )
+		{
+			for( const auto & t : qAsConst( c.m_trees ) )
+				t->interpolate( age );
+		}
+	}
+}
+
+void
+Forest::setQuality( const Quality & quality )
+{
+	for( const auto & t : qAsConst( m_trees ) )
+		t->setQuality( quality );
+}
+
+void
+Forest::buildGrid()
+{
+	if( m_trees.isEmpty() )
+		return;
+
+	float minX = m_trees.first()->position().x();
+	float minZ = m_trees.first()->position().z();
+	float maxX = minX;
+	float maxZ = minZ;
+
+	for( const auto & t : qAsConst( m_trees ) )
+	{
+		minX = qMin( minX, t->position().x() );
+		minZ = qMin( minZ, t->position().z() );
+		maxX = qMax( maxX, t->position().x() );
+		maxZ = qMax( maxZ, t->position().z() );
+	}
+
+	const int columns = (int) ( ( maxX - minX ) / c_forestCellSize ) + 1;
+	const int rows = (int) ( ( maxZ - minZ ) / c_forestCellSize ) + 1;
+
+	m_cells.resize( columns * rows );
+
+	for( int r = 0; r < rows; ++r )
+	{
+		for( int c = 0; c < columns; ++c )
+			m_cells[ r * columns + c ].m_center = QVector3D(
+				minX + ( (float) c + 0.5f ) * c_forestCellSize,
+				c_forestTreeCenter,
+				minZ + ( (float) r + 0.5f ) * c_forestCellSize );
+	}
+
+	for( const auto & t : qAsConst( m_trees ) )
+	{
+		const int c = (int) ( ( t->position().x() - minX ) / c_forestCellSize );
+		const int r = (int) ( ( t->position().z() - minZ ) / c_forestCellSize );
+
+		m_cells[ r * columns + c ].m_trees.append( t );
+	}
+
+	m_visibleTrees = m_trees.size();
+}
+
+void
+Forest::updateVisibility( const QMatrix4x4 & viewProjection,
+	const QVector3D & cameraPos )
+{
+	// Single tree doesn't need culling.
+	if( m_trees.size() < 2 )
+		return;
+
+	// Frustum planes.
+	const QVector4D r0 = viewProjection.row( 0 );
+	const QVector4D r1 = viewProjection.row( 1 );
+	const QVector4D r2 = viewProjection.row( 2 );
+	const QVector4D r3 = viewProjection.row( 3 );
+
+	const QVector4D planes[ 6 ] = {
+		r3 + r0, r3 - r0, r3 + r1, r3 - r1, r3 + r2, r3 - r2
+	};
+
+	const float radius = c_forestCellSize * 0.7072f + c_forestTreeRadius;
+
+	m_visibleTrees = 0;
+
+	for( auto & c : m_cells )
+	{
+		bool visible = true;
+
+		for( const auto & p : planes )
+		{
+			if( QVector3D::dotProduct( p.toVector3D(), c.m_center ) + p.w() <
+				- radius * p.toVector3D().length() )
+			{
+				visible = false;
+
+				break;
+			}
+		}
+
+		const bool leafs = visible &&
+			( c.m_center - cameraPos ).length() - radius < c_forestLeafsDistance;
+
+		if( visible != c.m_visible )
+		{
+			c.m_visible = visible;
+
+			for( const auto & t : qAsConst( c.m_trees ) )
+				t->setEnabled( visible );
+		}
+
+		if( leafs != c.m_leafs )
+		{
+			c.m_leafs = leafs;
+
+			for( const auto & t : qAsConst( c.m_trees ) )
+				t->setLeafsEnabled( leafs );
+		}
+
+		if( visible )
+			m_visibleTrees += c.m_trees.size();
+	}
+}
+
+int
+Forest::visibleTreesCount() const
+{
+	return m_visibleTrees;
+}
@@ -0,0 +1,125 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__FOREST_HPP__INCLUDED
+#define TREE__FOREST_HPP__INCLUDED
+
+// Qt include.
+#include <QVector>
+#include <QVector3D>
+#include <QMatrix4x4>
+
+QT_BEGIN_NAMESPACE
+
+namespace Qt3DCore {
+	class QEntity;
+}
+
+QT_END_NAMESPACE
+
+
+class Tree;
+struct TreeContext;
+struct Quality;
+
+
+//
+// Forest
+//
+
+//! Forest. Trees share mesh, material and instancing buffers of the
+//! context, spatial grid of the trees drives culling and LOD.
+class Forest Q_DECL_FINAL {
+public:
+	//! Placement of the trees.
+	enum Placement {
+		//! Regular grid.
+		Grid,
+		//! Random scatter.
+		Scatter
+	}; // enum Placement
+
+	Forest();
+	~Forest();
+
+	//! Create forest. Old trees are deleted.
+	void create( int count, Placement placement, quint32 seed,
+		const TreeContext & context, Qt3DCore::QEntity * parent );
+
+	//! Delete all trees.
+	void clear();
+
+	//! \return Is forest empty?
+	bool isEmpty() const;
+
+	//! \return Trees.
+	const QVector< Tree* > & trees() const;
+
+	//! Set age of the trees.
+	void setAge( float age );
+
+	//! Interpolate growth of visible trees.
+	void interpolate( float age );
+
+	//! Set quality of the trees.
+	void setQuality( const Quality & quality );
+
+	//! Update culling and LOD for the camera.
+	void updateVisibility( const QMatrix4x4 & viewProjection,
+		const QVector3D & cameraPos );
+
+	//! \return Count of visible trees.
+	int visibleTreesCount() const;
+
+private:
+	//! Cell of the spatial grid.
+	struct Cell {
+		Cell()
+			:	m_visible( true )
+			,	m_leafs( true )
+		{
+		}
+
+		//! Trees.
+		QVector< Tree* > m_trees;
+		//! Center.
+		QVector3D m_center;
+		//! Is visible?
+		bool m_visible;
+		//! Are leafs visible?
+		bool m_leafs;
+	}; // struct Cell
+
+	//! Build spatial grid.
+	void buildGrid();
+
+	Q_DISABLE_COPY( Forest )
+
+	//! Trees.
+	QVector< Tree* > m_trees;
+	//! Cells.
+	QVector< Cell > m_cells;
+	//! Count of visible trees.
+	int m_visibleTrees;
+}; // class Forest
+
+#endif // TREE__FOREST_HPP__INCLUDED
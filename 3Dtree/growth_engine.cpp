@@ -0,0 +1,102 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "growth_engine.hpp"
+#include "lsystem.hpp"
+#include "space_colonization.hpp"
+#include "branch_model.hpp"
+
+// Qt include.
+#include <QObject>
+#include <QStringList>
+
+// C++ include.
+#include <cmath>
+
+
+//
+// GrowthEngine
+//
+
+GrowthEngine::~GrowthEngine()
+{
+}
+
+std::unique_ptr< GrowthEngine >
+GrowthEngine::create( Type type, quint32 seed, const GrowthPolicy & policy,
+	bool enableDeath, int ticksPerYear )
+{
+	switch( type )
+	{
+		case LSystem :
+			return std::make_unique< LSystemEngine > ( seed, policy );
+
+		case SpaceColonization :
+			return std::make_unique< SpaceColonizationEngine > ( seed, policy );
+
+		case BranchModel :
+			return std::make_unique< BranchModelEngine > ( seed, policy,
+				enableDeath, ticksPerYear );
+
+		default :
+			return std::unique_ptr< GrowthEngine > ();
+	}
+}
+
+QStringList
+GrowthEngine::names()
+{
+	return QStringList() << QObject::tr( "Branches" )
+		<< QObject::tr( "L-system" )
+		<< QObject::tr( "Space Colonization" )
+		<< QObject::tr( "Branch Model" );
+}
+
+void
+GrowthEngine::applyPipeModel( std::vector< GrowthNode > & nodes,
+	float tipRadius )
+{
+	const float tip = tipRadius * tipRadius;
+
+	std::vector< float > area( nodes.size(), 0.0f );
+
+	// Children are after parents, so the backward pass sees all children
+	// of the node before the node.
+	for( auto i = (qint64) nodes.size() - 1; i >= 0; --i )
+	{
+		auto & n = nodes[ i ];
+
+		if( !n.m_alive )
+			continue;
+
+		const float top = ( area[ i ] > 0.0f ? area[ i ] : tip );
+		// Every segment adds one pipe, so chains taper to the top.
+		const float bottom = top + tip;
+
+		n.m_topRadius = std::sqrt( top );
+		n.m_bottomRadius = std::sqrt( bottom );
+
+		if( n.m_parent >= 0 )
+			area[ n.m_parent ] += bottom;
+	}
+}
@@ -0,0 +1,87 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__GROWTH_ENGINE_HPP__INCLUDED
+#define TREE__GROWTH_ENGINE_HPP__INCLUDED
+
+// 3Dtree include.
+#include "growth_model.hpp"
+
+// Qt include.
+#include <QStringList>
+
+// C++ include.
+#include <memory>
+#include <vector>
+
+
+//
+// GrowthEngine
+//
+
+//! Engine that grows the skeleton of the tree by generations, one
+//! generation a year. Alternative to the spawning of children by Branch,
+//! nodes are rendered by SkeletonEntity.
+class GrowthEngine {
+public:
+	//! Type of the engine.
+	enum Type {
+		//! Branches spawn their children themselves, no engine.
+		Branches = 0,
+		//! L-system.
+		LSystem = 1,
+		//! Space colonization.
+		SpaceColonization = 2,
+		//! Headless model of branches, grows by the rules of Branch on
+		//! the simulation thread.
+		BranchModel = 3
+	}; // enum Type
+
+	virtual ~GrowthEngine();
+
+	//! Grow the skeleton to the given generation, it should not be less
+	//! than the current one.
+	virtual void grow( int generation ) = 0;
+
+	//! \return Nodes. Parent of the node is always before the node, birth
+	//! of the node is the age of the tree when the node starts to grow.
+	//! Nodes of the previous generations keep their order, new nodes
+	//! may be inserted between them.
+	virtual const std::vector< GrowthNode > & nodes() const = 0;
+
+	//! \return Engine of the given type, null for Branches.
+	//! \par enableDeath and \par ticksPerYear are used by BranchModel.
+	static std::unique_ptr< GrowthEngine > create( Type type, quint32 seed,
+		const GrowthPolicy & policy, bool enableDeath = true,
+		int ticksPerYear = 600 );
+
+	//! \return Names of the engines, index is the type.
+	static QStringList names();
+
+	//! Set radii of the nodes by the pipe model: cross section of the node
+	//! is the sum of cross sections of its children, every tip is a pipe
+	//! of \par tipRadius.
+	static void applyPipeModel( std::vector< GrowthNode > & nodes,
+		float tipRadius );
+}; // class GrowthEngine
+
+#endif // TREE__GROWTH_ENGINE_HPP__INCLUDED
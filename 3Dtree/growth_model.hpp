@@ -0,0 +1,447 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__GROWTH_MODEL_HPP__INCLUDED
+#define TREE__GROWTH_MODEL_HPP__INCLUDED
+
+// 3Dtree include.
+#include "growth_policy.hpp"
+
+// Qt include.
+#include <QVector3D>
+#include <QQuaternion>
+#include <QtMath>
+
+// C++ include.
+#include <vector>
+#include <random>
+#include <cmath>
+#include <limits>
+
+
+//
+// GrowthNode
+//
+
+//! Branch of the headless tree.
+struct GrowthNode Q_DECL_FINAL {
+	//! Index of the parent, -1 for the trunk.
+	qint32 m_parent;
+	//! Indexes of the children.
+	std::vector< qint32 > m_children;
+	//! Age of the tree when this branch was born.
+	float m_birth;
+	//! Start length.
+	float m_length;
+	//! Bottom radius without scale.
+	float m_bottomRadius;
+	//! Top radius without scale.
+	float m_topRadius;
+	//! Direction.
+	QVector3D m_direction;
+	//! Start position, valid after evaluate().
+	QVector3D m_startPos;
+	//! End position, valid after evaluate().
+	QVector3D m_endPos;
+	//! Is this a part of the trunk?
+	bool m_isTree;
+	//! Is this a first branch?
+	bool m_firstBranch;
+	//! Is this branch alive?
+	bool m_alive;
+}; // struct GrowthNode
+
+
+//
+// GrowthStats
+//
+
+//! Statistics of the headless tree.
+struct GrowthStats Q_DECL_FINAL {
+	//! Count of live branches.
+	float m_branches;
+	//! Count of leafs.
+	float m_leafs;
+	//! Height.
+	float m_height;
+	//! Crown radius.
+	float m_crownRadius;
+}; // struct GrowthStats
+
+
+//
+// BasicGrowthModel
+//
+
+//! Headless tree, grows by the same rules as Branch without any
+//! Qt3D entities. Parameterized on the growth policy, with species
+//! presets constants are inlined.
+template< typename Policy >
+class BasicGrowthModel Q_DECL_FINAL {
+public:
+	explicit BasicGrowthModel( quint32 seed, bool enableDeath = true,
+		int ticksPerYear = 600, const Policy & policy = Policy() );
+
+	//! \return Policy.
+	const Policy & policy() const;
+
+	//! \return Age of the tree.
+	float age() const;
+
+	//! Grow the tree to the given age, it should not be less than
+	//! current age. Death of branches is rolled with the probability
+	//! equal to per tick rolls of the Branch.
+	void setAge( float age );
+
+	//! Compute positions of the branches for the current age.
+	void evaluate();
+
+	//! \return Statistics for the current age. Positions should be
+	//! evaluated.
+	GrowthStats stats() const;
+
+	//! \return Branches. Dead branches are kept with m_alive == false.
+	const std::vector< GrowthNode > & nodes() const;
+
+	//! \return Summer age of the branch, i.e. age of growth.
+	static float summerAge( float age );
+	//! \return Scale of the branch.
+	float scale( float age ) const;
+	//! \return Length of the branch with scale.
+	float length( const GrowthNode & node, float age ) const;
+
+private:
+	//! Spawn children of the branch, recursively for old enough children.
+	void spawn( qint32 idx );
+	//! Kill the branch with children.
+	void kill( qint32 idx );
+	//! Roll death of the branch for the age interval.
+	bool rollDeath( float from, float to );
+	//! \return Has branch live children?
+	bool hasChildren( const GrowthNode & node ) const;
+
+	//! Policy.
+	Policy m_policy;
+	//! Branches.
+	std::vector< GrowthNode > m_nodes;
+	//! Age.
+	float m_age;
+	//! Enable death?
+	bool m_enableDeath;
+	//! Ticks in one year.
+	int m_ticksPerYear;
+	//! Probability of death per tick.
+	double m_deathProbability;
+	//! Random numbers generator.
+	std::mt19937 m_gen;
+}; // class BasicGrowthModel
+
+//! Growth model of the default species.
+typedef BasicGrowthModel< DefaultSpecies > GrowthModel;
+
+
+//! \return Length of intersection of two ranges.
+static inline float ageOverlap( float from, float to, float min, float max )
+{
+	return qMax( 0.0f, qMin( to, max ) - qMax( from, min ) );
+}
+
+template< typename Policy >
+BasicGrowthModel< Policy >::BasicGrowthModel( quint32 seed,
+	bool enableDeath, int ticksPerYear, const Policy & policy )
+	:	m_policy( policy )
+	,	m_age( 0.0f )
+	,	m_enableDeath( enableDeath )
+	,	m_ticksPerYear( ticksPerYear )
+	// Branch dies when sample of N( 0.0, 0.5 ) >= death probability.
+	,	m_deathProbability( 0.5 * std::erfc( m_policy.deathProbability() /
+			( 0.5 * std::sqrt( 2.0 ) ) ) )
+	,	m_gen( seed )
+{
+	GrowthNode root;
+	root.m_parent = -1;
+	root.m_birth = 0.0f;
+	root.m_length = m_policy.branchLength();
+	root.m_bottomRadius = m_policy.startBranchRadius();
+	root.m_topRadius = m_policy.startBranchRadius() -
+		m_policy.branchRadiusDelta();
+	root.m_direction = QVector3D( 0.0f, 1.0f, 0.0f );
+	root.m_isTree = true;
+	root.m_firstBranch = true;
+	root.m_alive = true;
+
+	m_nodes.push_back( root );
+}
+
+template< typename Policy >
+const Policy &
+BasicGrowthModel< Policy >::policy() const
+{
+	return m_policy;
+}
+
+template< typename Policy >
+float
+BasicGrowthModel< Policy >::age() const
+{
+	return m_age;
+}
+
+template< typename Policy >
+const std::vector< GrowthNode > &
+BasicGrowthModel< Policy >::nodes() const
+{
+	return m_nodes;
+}
+
+template< typename Policy >
+float
+BasicGrowthModel< Policy >::summerAge( float age )
+{
+	float i = std::floor( age );
+	float tmp = age - i;
+
+	if( tmp <= 0.25f )
+		tmp *= 4.0f;
+	else
+		tmp = 1.0f;
+
+	return i + tmp;
+}
+
+template< typename Policy >
+float
+BasicGrowthModel< Policy >::scale( float age ) const
+{
+	const float s = summerAge( age );
+
+	return ( s <= 1.0f ? s : 1.0f + s / ( 100.0f / m_policy.branchScale() ) );
+}
+
+template< typename Policy >
+float
+BasicGrowthModel< Policy >::length( const GrowthNode & node, float age ) const
+{
+	const float s = summerAge( age );
+
+	return ( node.m_length +
+		node.m_length * s / ( 100.0f / m_policy.branchLengthMultiplicator() ) /
+		( !node.m_isTree ? m_policy.branchSlower() : 1.0f ) *
+		( node.m_firstBranch ? m_policy.firstBranchGrowsFaster() : 1.0f ) ) *
+		scale( age );
+}
+
+template< typename Policy >
+bool
+BasicGrowthModel< Policy >::hasChildren( const GrowthNode & node ) const
+{
+	for( const auto & c : node.m_children )
+	{
+		if( m_nodes[ c ].m_alive )
+			return true;
+	}
+
+	return false;
+}
+
+template< typename Policy >
+void
+BasicGrowthModel< Policy >::setAge( float age )
+{
+	const float from = m_age;
+
+	m_age = age;
+
+	const size_t count = m_nodes.size();
+
+	for( size_t i = 0; i < count; ++i )
+	{
+		if( !m_nodes[ i ].m_alive )
+			continue;
+
+		const float birth = m_nodes[ i ].m_birth;
+
+		if( age - birth >= 1.0f && !hasChildren( m_nodes[ i ] ) )
+			spawn( (qint32) i );
+
+		if( m_enableDeath && !m_nodes[ i ].m_isTree &&
+			rollDeath( from - birth, age - birth ) )
+				kill( (qint32) i );
+	}
+}
+
+template< typename Policy >
+bool
+BasicGrowthModel< Policy >::rollDeath( float from, float to )
+{
+	// Branch rolls death while rounded age is in ( 1, min ) or ( max, inf ).
+	const float ticks = ( ageOverlap( from, to, 1.5f,
+			(float) m_policy.minDeathThreeshold() - 0.5f ) +
+		ageOverlap( from, to, (float) m_policy.maxDeathThreeshold() + 0.5f,
+			std::numeric_limits< float >::max() ) ) * (float) m_ticksPerYear;
+
+	if( ticks <= 0.0f )
+		return false;
+
+	const double p = 1.0 - std::pow( 1.0 - m_deathProbability,
+		(double) ticks );
+
+	std::uniform_real_distribution< double > dis( 0.0, 1.0 );
+
+	return ( dis( m_gen ) < p );
+}
+
+template< typename Policy >
+void
+BasicGrowthModel< Policy >::kill( qint32 idx )
+{
+	m_nodes[ idx ].m_alive = false;
+
+	const auto children = m_nodes[ idx ].m_children;
+
+	for( const auto & c : children )
+	{
+		if( m_nodes[ c ].m_alive )
+			kill( c );
+	}
+}
+
+template< typename Policy >
+void
+BasicGrowthModel< Policy >::spawn( qint32 idx )
+{
+	const float birth = m_nodes[ idx ].m_birth + 1.0f;
+	const QVector3D parent = m_nodes[ idx ].m_direction;
+	const float parentRadius = m_nodes[ idx ].m_topRadius *
+		scale( m_age - m_nodes[ idx ].m_birth );
+	const bool isTree = m_nodes[ idx ].m_isTree;
+
+	std::uniform_real_distribution< float > ldis( 0.0f,
+		m_policy.branchLengthDistortion() );
+	std::uniform_real_distribution< float > rdis( 0.0f,
+		m_policy.branchDistortion() );
+	std::uniform_real_distribution< float > adis( 0.0f,
+		m_policy.maxBranchAngle() );
+	std::uniform_real_distribution< float > dis( 0.0f,
+		m_policy.branchRotationDistortion() );
+
+	auto add = [&] ( const QVector3D & dir, float bottomRadius, bool tree )
+	{
+		GrowthNode n;
+		n.m_parent = idx;
+		n.m_birth = birth;
+		n.m_length = m_policy.branchLength() + ldis( m_gen );
+		n.m_bottomRadius = bottomRadius;
+		n.m_topRadius = bottomRadius - m_policy.branchRadiusDelta();
+		n.m_direction = dir;
+		n.m_isTree = tree;
+		n.m_firstBranch = false;
+		n.m_alive = true;
+
+		m_nodes.push_back( n );
+		m_nodes[ idx ].m_children.push_back( (qint32) m_nodes.size() - 1 );
+	};
+
+	if( m_policy.hasContinuationBranch() )
+		add( parent, parentRadius, isTree );
+
+	const quint8 count = m_policy.childBranchesCount() -
+		( m_policy.hasContinuationBranch() ? 1 : 0 );
+
+	const QVector3D b( 0.0f, 1.0f, 0.0f );
+
+	QVector3D axis = QVector3D::crossProduct( b, parent ).normalized();
+
+	if( axis.isNull() )
+		axis = QVector3D( 1.0f, 0.0f, 0.0f );
+
+	const float cosAngle = QVector3D::dotProduct( b, parent );
+
+	float angle = dis( m_gen );
+
+	for( quint8 i = 0; i < count; ++i )
+	{
+		const float plainAngle = qRadiansToDegrees( std::acos( cosAngle ) ) +
+			90.0f - adis( m_gen );
+
+		const QQuaternion q = QQuaternion::fromAxisAndAngle( parent, angle ) *
+			QQuaternion::fromAxisAndAngle( axis, plainAngle );
+
+		add( q.rotatedVector( b ).normalized(), parentRadius - rdis( m_gen ),
+			false );
+
+		angle += 360.0f / (float) count;
+	}
+
+	// Old enough children grow their own children at once.
+	if( m_age - birth >= 1.0f )
+	{
+		const auto children = m_nodes[ idx ].m_children;
+
+		for( const auto & c : children )
+		{
+			if( m_nodes[ c ].m_alive && !hasChildren( m_nodes[ c ] ) )
+				spawn( c );
+		}
+	}
+}
+
+template< typename Policy >
+void
+BasicGrowthModel< Policy >::evaluate()
+{
+	for( auto & n : m_nodes )
+	{
+		if( !n.m_alive )
+			continue;
+
+		n.m_startPos = ( n.m_parent < 0 ? QVector3D( 0.0f, 0.0f, 0.0f ) :
+			m_nodes[ n.m_parent ].m_endPos );
+		n.m_endPos = n.m_startPos + n.m_direction * length( n, m_age - n.m_birth );
+	}
+}
+
+template< typename Policy >
+GrowthStats
+BasicGrowthModel< Policy >::stats() const
+{
+	GrowthStats s = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	for( const auto & n : m_nodes )
+	{
+		if( !n.m_alive )
+			continue;
+
+		s.m_branches += 1.0f;
+
+		if( m_age - n.m_birth < 1.0f )
+			s.m_leafs += (float) m_policy.leafsCount();
+
+		s.m_height = qMax( s.m_height, n.m_endPos.y() );
+		s.m_crownRadius = qMax( s.m_crownRadius,
+			QVector3D( n.m_endPos.x(), 0.0f, n.m_endPos.z() ).length() );
+	}
+
+	return s;
+}
+
+#endif // TREE__GROWTH_MODEL_HPP__INCLUDED
@@ -0,0 +1,226 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "growth_policy.hpp"
+
+// Qt include.
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QObject>
+
+// C++ include.
+#include <utility>
+
+
+//
+// GrowthPolicy
+//
+
+GrowthPolicy::GrowthPolicy()
+	:	m_name( DefaultSpecies::name() )
+	,	m_leafBaseScale( c_leafBaseScale )
+	,	m_leafAngle( c_leafAngle )
+	,	m_leafRotationDistortion( c_leafRotationDistortion )
+	,	m_leafsCount( c_leafsCount )
+	,	m_branchDistortion( c_branchDistortion )
+	,	m_branchRadiusDelta( c_branchRadiusDelta )
+	,	m_startBranchRadius( c_startBranchRadius )
+	,	m_branchLength( c_branchLength )
+	,	m_branchLengthDistortion( c_branchLengthDistortion )
+	,	m_maxBranchAngle( c_maxBranchAngle )
+	,	m_childBranchesCount( c_childBranchesCount )
+	,	m_hasContinuationBranch( c_hasContinuationBranch )
+	,	m_branchRotationDistortion( c_branchRotationDistortion )
+	,	m_branchLengthMultiplicator( c_branchLengthMultiplicator )
+	,	m_branchSlower( c_branchSlower )
+	,	m_branchScale( c_branchScale )
+	,	m_firstBranchGrowsFaster( c_firstBranchGrowsFaster )
+	,	m_minDeathThreeshold( c_minDeathThreeshold )
+	,	m_maxDeathThreeshold( c_maxDeathThreeshold )
+	,	m_deathProbability( c_deathProbability )
+{
+}
+
+GrowthPolicy
+GrowthPolicy::builtIn( const QString & name )
+{
+	if( name == SparseSpecies::name() )
+		return fromSpecies< SparseSpecies > ();
+	else if( name == DenseSpecies::name() )
+		return fromSpecies< DenseSpecies > ();
+	else
+		return fromSpecies< DefaultSpecies > ();
+}
+
+QStringList
+GrowthPolicy::builtInNames()
+{
+	return QStringList() << DefaultSpecies::name() << SparseSpecies::name()
+		<< DenseSpecies::name();
+}
+
+//! Read float value from JSON.
+static inline void readValue( const QJsonObject & o, const char * key,
+	float & value )
+{
+	const auto v = o.value( QLatin1String( key ) );
+
+	if( v.isDouble() )
+		value = (float) v.toDouble();
+}
+
+//! Read integer value from JSON.
+static inline void readValue( const QJsonObject & o, const char * key,
+	quint8 & value )
+{
+	const auto v = o.value( QLatin1String( key ) );
+
+	if( v.isDouble() )
+		value = (quint8) qBound( 0, v.toInt(), 255 );
+}
+
+//! Read boolean value from JSON.
+static inline void readValue( const QJsonObject & o, const char * key,
+	bool & value )
+{
+	const auto v = o.value( QLatin1String( key ) );
+
+	if( v.isBool() )
+		value = v.toBool();
+}
+
+bool
+GrowthPolicy::load( const QString & fileName, GrowthPolicy & policy,
+	QString * error )
+{
+	QFile file( fileName );
+
+	if( !file.open( QIODevice::ReadOnly ) )
+	{
+		if( error )
+			*error = QObject::tr( "Unable to open %1." ).arg( fileName );
+
+		return false;
+	}
+
+	QJsonParseError err;
+
+	const QJsonDocument doc = QJsonDocument::fromJson( file.readAll(), &err );
+
+	if( err.error != QJsonParseError::NoError || !doc.isObject() )
+	{
+		if( error )
+			*error = QObject::tr( "Wrong JSON in %1: %2." )
+				.arg( fileName, err.errorString() );
+
+		return false;
+	}
+
+	const QJsonObject o = doc.object();
+
+	GrowthPolicy p = builtIn( o.value( QLatin1String( "species" ) ).toString() );
+
+	p.m_name = o.value( QLatin1String( "name" ) )
+		.toString( QFileInfo( fileName ).baseName() );
+
+	readValue( o, "leafBaseScale", p.m_leafBaseScale );
+	readValue( o, "leafAngle", p.m_leafAngle );
+	readValue( o, "leafRotationDistortion", p.m_leafRotationDistortion );
+	readValue( o, "leafsCount", p.m_leafsCount );
+	readValue( o, "branchDistortion", p.m_branchDistortion );
+	readValue( o, "branchRadiusDelta", p.m_branchRadiusDelta );
+	readValue( o, "startBranchRadius", p.m_startBranchRadius );
+	readValue( o, "branchLength", p.m_branchLength );
+	readValue( o, "branchLengthDistortion", p.m_branchLengthDistortion );
+	readValue( o, "maxBranchAngle", p.m_maxBranchAngle );
+	readValue( o, "childBranchesCount", p.m_childBranchesCount );
+	readValue( o, "hasContinuationBranch", p.m_hasContinuationBranch );
+	readValue( o, "branchRotationDistortion", p.m_branchRotationDistortion );
+	readValue( o, "branchLengthMultiplicator", p.m_branchLengthMultiplicator );
+	readValue( o, "branchSlower", p.m_branchSlower );
+	readValue( o, "branchScale", p.m_branchScale );
+	readValue( o, "firstBranchGrowsFaster", p.m_firstBranchGrowsFaster );
+	readValue( o, "minDeathThreeshold", p.m_minDeathThreeshold );
+	readValue( o, "maxDeathThreeshold", p.m_maxDeathThreeshold );
+	readValue( o, "deathProbability", p.m_deathProbability );
+
+	if( p.m_childBranchesCount < 1 )
+	{
+		if( error )
+			*error = QObject::tr( "childBranchesCount can't be less than 1." );
+
+		return false;
+	}
+
+	// Distortions are upper bounds of random ranges.
+	const std::pair< const char*, float > ranges[] = {
+		{ "leafAngle", p.m_leafAngle },
+		{ "leafRotationDistortion", p.m_leafRotationDistortion },
+		{ "branchDistortion", p.m_branchDistortion },
+		{ "branchRadiusDelta", p.m_branchRadiusDelta },
+		{ "branchLengthDistortion", p.m_branchLengthDistortion },
+		{ "maxBranchAngle", p.m_maxBranchAngle },
+		{ "branchRotationDistortion", p.m_branchRotationDistortion }
+	};
+
+	for( const auto & r : ranges )
+	{
+		if( !( r.second >= 0.0f ) )
+		{
+			if( error )
+				*error = QObject::tr( "%1 can't be negative." )
+					.arg( QLatin1String( r.first ) );
+
+			return false;
+		}
+	}
+
+	// Sizes and divisors.
+	const std::pair< const char*, float > sizes[] = {
+		{ "leafBaseScale", p.m_leafBaseScale },
+		{ "startBranchRadius", p.m_startBranchRadius },
+		{ "branchLength", p.m_branchLength },
+		{ "branchLengthMultiplicator", p.m_branchLengthMultiplicator },
+		{ "branchSlower", p.m_branchSlower },
+		{ "branchScale", p.m_branchScale },
+		{ "firstBranchGrowsFaster", p.m_firstBranchGrowsFaster }
+	};
+
+	for( const auto & sz : sizes )
+	{
+		if( !( sz.second > 0.0f ) )
+		{
+			if( error )
+				*error = QObject::tr( "%1 should be greater than 0." )
+					.arg( QLatin1String( sz.first ) );
+
+			return false;
+		}
+	}
+
+	policy = p;
+
+	return true;
+}
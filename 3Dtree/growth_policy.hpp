@@ -0,0 +1,218 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__GROWTH_POLICY_HPP__INCLUDED
+#define TREE__GROWTH_POLICY_HPP__INCLUDED
+
+// 3Dtree include.
+#include "constants.hpp"
+
+// Qt include.
+#include <QString>
+#include <QStringList>
+
+
+//
+// Growth policies.
+//
+// Every policy has the same set of accessors named after constants in
+// constants.hpp. Species presets have static accessors, so code
+// parameterized on them gets constants inlined. GrowthPolicy reads
+// values loaded at runtime.
+//
+
+
+//
+// DefaultSpecies
+//
+
+//! Default species, values of constants.hpp.
+struct DefaultSpecies {
+	static QString name() { return QStringLiteral( "default" ); }
+
+	static float leafBaseScale() { return c_leafBaseScale; }
+	static float leafAngle() { return c_leafAngle; }
+	static float leafRotationDistortion() { return c_leafRotationDistortion; }
+	static quint8 leafsCount() { return c_leafsCount; }
+
+	static float branchDistortion() { return c_branchDistortion; }
+	static float branchRadiusDelta() { return c_branchRadiusDelta; }
+	static float startBranchRadius() { return c_startBranchRadius; }
+	static float branchLength() { return c_branchLength; }
+	static float branchLengthDistortion() { return c_branchLengthDistortion; }
+	static float maxBranchAngle() { return c_maxBranchAngle; }
+	static quint8 childBranchesCount() { return c_childBranchesCount; }
+	static bool hasContinuationBranch() { return c_hasContinuationBranch; }
+	static float branchRotationDistortion() { return c_branchRotationDistortion; }
+	static float branchLengthMultiplicator() { return c_branchLengthMultiplicator; }
+	static float branchSlower() { return c_branchSlower; }
+	static float branchScale() { return c_branchScale; }
+	static float firstBranchGrowsFaster() { return c_firstBranchGrowsFaster; }
+	static quint8 minDeathThreeshold() { return c_minDeathThreeshold; }
+	static quint8 maxDeathThreeshold() { return c_maxDeathThreeshold; }
+	static float deathProbability() { return c_deathProbability; }
+}; // struct DefaultSpecies
+
+
+//
+// SparseSpecies
+//
+
+//! Sparse species: three children, narrow crown, long branches.
+struct SparseSpecies
+	:	public DefaultSpecies
+{
+	static QString name() { return QStringLiteral( "sparse" ); }
+
+	static float branchLength() { return 0.65f; }
+	static float maxBranchAngle() { return 40.0f; }
+	static quint8 childBranchesCount() { return 3; }
+	static quint8 leafsCount() { return 3; }
+}; // struct SparseSpecies
+
+
+//
+// DenseSpecies
+//
+
+//! Dense species: five children, wide crown, short branches.
+struct DenseSpecies
+	:	public DefaultSpecies
+{
+	static QString name() { return QStringLiteral( "dense" ); }
+
+	static float branchLength() { return 0.4f; }
+	static float maxBranchAngle() { return 65.0f; }
+	static quint8 childBranchesCount() { return 5; }
+	static float deathProbability() { return 1.6f; }
+}; // struct DenseSpecies
+
+
+//
+// GrowthPolicy
+//
+
+//! Growth policy loaded at runtime.
+class GrowthPolicy Q_DECL_FINAL {
+public:
+	GrowthPolicy();
+
+	//! \return Policy with values of the species.
+	template< typename Species >
+	static GrowthPolicy fromSpecies();
+
+	//! \return Policy of the built-in species with the given name,
+	//! default species if name is unknown.
+	static GrowthPolicy builtIn( const QString & name );
+
+	//! \return Names of built-in species.
+	static QStringList builtInNames();
+
+	//! Load policy from JSON file. Missing keys keep default values.
+	//! \return false and error message on failure.
+	static bool load( const QString & fileName, GrowthPolicy & policy,
+		QString * error = Q_NULLPTR );
+
+	const QString & name() const { return m_name; }
+
+	float leafBaseScale() const { return m_leafBaseScale; }
+	float leafAngle() const { return m_leafAngle; }
+	float leafRotationDistortion() const { return m_leafRotationDistortion; }
+	quint8 leafsCount() const { return m_leafsCount; }
+
+	float branchDistortion() const { return m_branchDistortion; }
+	float branchRadiusDelta() const { return m_branchRadiusDelta; }
+	float startBranchRadius() const { return m_startBranchRadius; }
+	float branchLength() const { return m_branchLength; }
+	float branchLengthDistortion() const { return m_branchLengthDistortion; }
+	float maxBranchAngle() const { return m_maxBranchAngle; }
+	quint8 childBranchesCount() const { return m_childBranchesCount; }
+	bool hasContinuationBranch() const { return m_hasContinuationBranch; }
+	float branchRotationDistortion() const { return m_branchRotationDistortion; }
+	float branchLengthMultiplicator() const { return m_branchLengthMultiplicator; }
+	float branchSlower() const { return m_branchSlower; }
+	float branchScale() const { return m_branchScale; }
+	float firstBranchGrowsFaster() const { return m_firstBranchGrowsFaster; }
+	quint8 minDeathThreeshold() const { return m_minDeathThreeshold; }
+	quint8 maxDeathThreeshold() const { return m_maxDeathThreeshold; }
+	float deathProbability() const { return m_deathProbability; }
+
+private:
+	QString m_name;
+
+	float m_leafBaseScale;
+	float m_leafAngle;
+	float m_leafRotationDistortion;
+	quint8 m_leafsCount;
+
+	float m_branchDistortion;
+	float m_branchRadiusDelta;
+	float m_startBranchRadius;
+	float m_branchLength;
+	float m_branchLengthDistortion;
+	float m_maxBranchAngle;
+	quint8 m_childBranchesCount;
+	bool m_hasContinuationBranch;
+	float m_branchRotationDistortion;
+	float m_branchLengthMultiplicator;
+	float m_branchSlower;
+	float m_branchScale;
+	float m_firstBranchGrowsFaster;
+	quint8 m_minDeathThreeshold;
+	quint8 m_maxDeathThreeshold;
+	float m_deathProbability;
+}; // class GrowthPolicy
+
+template< typename Species >
+GrowthPolicy
+GrowthPolicy::fromSpecies()
+{
+	GrowthPolicy p;
+
+	p.m_name = Species::name();
+
+	p.m_leafBaseScale = Species::leafBaseScale();
+	p.m_leafAngle = Species::leafAngle();
+	p.m_leafRotationDistortion = Species::leafRotationDistortion();
+	p.m_leafsCount = Species::leafsCount();
+
+	p.m_branchDistortion = Species::branchDistortion();
+	p.m_branchRadiusDelta = Species::branchRadiusDelta();
+	p.m_startBranchRadius = Species::startBranchRadius();
+	p.m_branchLength = Species::branchLength();
+	p.m_branchLengthDistortion = Species::branchLengthDistortion();
+	p.m_maxBranchAngle = Species::maxBranchAngle();
+	p.m_childBranchesCount = Species::childBranchesCount();
+	p.m_hasContinuationBranch = Species::hasContinuationBranch();
+	p.m_branchRotationDistortion = Species::branchRotationDistortion();
+	p.m_branchLengthMultiplicator = Species::branchLengthMultiplicator();
+	p.m_branchSlower = Species::branchSlower();
+	p.m_branchScale = Species::branchScale();
+	p.m_firstBranchGrowsFaster = Species::firstBranchGrowsFaster();
+	p.m_minDeathThreeshold = Species::minDeathThreeshold();
+	p.m_maxDeathThreeshold = Species::maxDeathThreeshold();
+	p.m_deathProbability = Species::deathProbability();
+
+	return p;
+}
+
+#endif // TREE__GROWTH_POLICY_HPP__INCLUDED
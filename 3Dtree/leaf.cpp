@@ -24,11 +24,14 @@
 #include "leaf.hpp"
 #include "constants.hpp"
 #include "branch.hpp"
+#include "tree_context.hpp"
+#include "change_counter.hpp"
+#include "tree_material.hpp"
+#include "leaf_budget.hpp"
 
 // Qt include.
-#include <Qt3DExtras/QPhongMaterial>
 #include <Qt3DCore/QTransform>
-#include <Qt3DRender/QMesh>
+#include <Qt3DRender/QGeometryRenderer>
 
 #include <QtMath>
 #include <QPixmap>
@@ -42,7 +45,27 @@
 #include <memory>
 
 
-using namespace Qt3DExtras;
+//! Interval of the animation timer that fall speed is given for.
+static const float c_fallBaseInterval = 100.0f;
+//! Flutter of the leaf in the wind.
+static const float c_leafFlutter = 0.15f;
+
+
+//! \return Age in [from, sure] the roll uniform( a, end ) > sure on every
+//! tick at age a first succeeds at. Probability to fail all rolls till
+//! the age t is ( ( end - t ) / ( end - from ) )^( ( end - sure ) * ticks ),
+//! so the age is sampled by the inversion of it.
+static inline float firstSuccess( float from, float end, float sure,
+	float ticksPerYear, std::mt19937 & gen )
+{
+	if( from >= sure )
+		return from;
+
+	std::uniform_real_distribution< float > dis( 0.0f, 1.0f );
+
+	return qMin( end - ( end - from ) *
+		std::pow( dis( gen ), 1.0f / ( ( end - sure ) * ticksPerYear ) ), sure );
+}
 
 
 //
@@ -52,39 +75,47 @@ using namespace Qt3DExtras;
 class LeafPrivate {
 public:
 	LeafPrivate( const QVector3D & startBranchPos,
-		const QVector3D & endBranchPos, Qt3DRender::QMesh * mesh,
-		QTimer * animationTimer, Branch * parentBranch, Leaf * parent,
-		quint64 & entityCounter, bool useInstanceRendering )
-		:	m_mesh( mesh )
+		const QVector3D & endBranchPos, TreeContext * context,
+		Branch * parentBranch, Leaf * parent )
+		:	m_context( context )
+		,	m_mesh( context->m_leafMesh )
 		,	m_material( Q_NULLPTR )
 		,	m_transform( Q_NULLPTR )
 		,	m_startBranchPos( &startBranchPos )
 		,	m_endBranchPos( &endBranchPos )
-		,	m_timer( animationTimer )
+		,	m_timer( context->m_animationTimer )
 		,	m_fallAngle( 0.0f )
 		,	m_branch( parentBranch )
 		,	q( parent )
-		,	m_entityCounter( entityCounter )
-		,	m_useInstanceRendering( useInstanceRendering )
+		,	m_entityCounter( *context->m_entityCounter )
+		,	m_useInstanceRendering( context->m_useInstanceRendering )
 		,	m_startBranchRot( 0.0f )
 		,	m_leafDistRot( -1.0f )
 		,	m_fallAndDie( false )
 	{
 		++m_entityCounter;
+
+		if( m_context->m_leafBudget )
+			m_context->m_leafBudget->addLeaf();
 	}
 
 	~LeafPrivate()
 	{
 		--m_entityCounter;
+
+		if( m_context->m_leafBudget )
+			m_context->m_leafBudget->removeLeaf();
 	}
 
 	//! Init.
 	void init();
 
+	//! Tree context.
+	TreeContext * m_context;
 	//! Mesh.
-	Qt3DRender::QMesh * m_mesh;
+	Qt3DRender::QGeometryRenderer * m_mesh;
 	//! Material.
-	QPhongMaterial * m_material;
+	TreeMaterial * m_material;
 	//! Transform.
 	Qt3DCore::QTransform * m_transform;
 	//! Start branch position.
@@ -120,9 +151,10 @@ LeafPrivate::init()
 {
 	q->addComponent( m_mesh );
 
-	auto material = std::make_unique< QPhongMaterial > ();
+	auto material = std::make_unique< TreeMaterial > ( m_context->m_effect );
 
 	material->setDiffuse( Qt::darkGreen );
+	material->setFlutter( c_leafFlutter );
 
 	m_material = material.get();
 
@@ -136,11 +168,17 @@ LeafPrivate::init()
 
 	q->addComponent( transform.release() );
 
-	std::random_device rd;
-	std::mt19937 gen( rd() );
 	std::uniform_real_distribution< float > dis( 0.0f, 360.0f );
 
+	auto & gen = m_context->m_generator;
+
 	m_fallAngle = dis( gen );
+
+	if( m_context->m_changeCounter )
+	{
+		m_context->m_changeCounter->watch( q );
+		m_context->m_changeCounter->watch( m_mesh );
+	}
 }
 
 
@@ -149,13 +187,11 @@ LeafPrivate::init()
 //
 
 Leaf::Leaf( const QVector3D & startBranchPos,
-	const QVector3D & endBranchPos, Qt3DRender::QMesh * mesh,
-	QTimer * animationTimer, Branch * parentBranch, quint64 & entityCounter,
-	Qt3DCore::QNode * parent, bool useInstanceRendering )
+	const QVector3D & endBranchPos, TreeContext * context,
+	Branch * parentBranch, Qt3DCore::QNode * parent )
 	:	Qt3DCore::QEntity( parent )
-	,	d( new LeafPrivate( startBranchPos, endBranchPos, mesh,
-			animationTimer, parentBranch, this, entityCounter,
-			useInstanceRendering ) )
+	,	d( new LeafPrivate( startBranchPos, endBranchPos, context,
+			parentBranch, this ) )
 {
 	d->init();
 }
@@ -171,13 +207,11 @@ Leaf::setColor( const QColor & c )
 }
 
 QColor
-Leaf::autumnColor()
+Leaf::autumnColor( std::mt19937 & gen )
 {
 	static QImage img;
 
-	static std::random_device rd;
-	static std::mt19937 gen( rd() );
-	static std::uniform_int_distribution< int > autumn( 0, 99 );
+	std::uniform_int_distribution< int > autumn( 0, 99 );
 
 	if( img.isNull() )
 	{
@@ -199,15 +233,54 @@ Leaf::autumnColor()
 	return img.pixelColor( autumn( gen ), 1 );
 }
 
+float
+Leaf::turnAge( float from, TreeContext * context )
+{
+	return firstSuccess( qMax( from, 0.5f ), 0.75f, 0.63f,
+		context->m_ticksPerYear, context->m_generator );
+}
+
+float
+Leaf::fallAge( float from, TreeContext * context )
+{
+	return firstSuccess( qMax( from, 0.75f ), 0.97f, 0.96f,
+		context->m_ticksPerYear, context->m_generator );
+}
+
+void
+Leaf::setSeason( float birthAge )
+{
+	auto & gen = d->m_context->m_generator;
+	std::uniform_int_distribution< int > autumn( 0, 99 );
+
+	const float turn = turnAge( 0.0f, d->m_context );
+	const int index = autumn( gen );
+
+	d->m_material->setGrowth( birthAge, 0.0f, TreeMaterial::LeafGrowth );
+	d->m_material->setSeason( turn, index, fallAge( 0.0f, d->m_context ) );
+
+	// Shader scales the leaf.
+	d->m_transform->setScale( d->m_context->m_policy.leafBaseScale() );
+}
+
 void
 Leaf::setAge( float age )
 {
+	if( d->m_context->m_gpuSeasons )
+		return;
+
 	if( age > 1.0f )
 		age = 1.0f;
 	else if( age < 0.0f )
 		age = 0.0f;
 
-	d->m_transform->setScale( c_leafBaseScale * age );
+	d->m_transform->setScale( d->m_context->m_policy.leafBaseScale() * age );
+}
+
+void
+Leaf::setSpringOffset( const QVector3D & offset )
+{
+	d->m_material->setSpringOffset( offset );
 }
 
 void
@@ -218,6 +291,16 @@ Leaf::updatePosition()
 	rotate( d->m_startBranchRot );
 }
 
+void
+Leaf::reanchor( const QVector3D * from, const QVector3D * to )
+{
+	if( d->m_startBranchPos == from )
+		d->m_startBranchPos = to;
+
+	if( d->m_endBranchPos == from )
+		d->m_endBranchPos = to;
+}
+
 void
 Leaf::rotate( float angle )
 {
@@ -237,9 +320,9 @@ Leaf::rotate( float angle )
 
 	if( d->m_leafDistRot < 0.0f || d->m_fallAndDie )
 	{
-		std::random_device rd;
-		std::mt19937 gen( rd() );
-		std::uniform_real_distribution< float > dis( 0.0f, c_leafAngle );
+		auto & gen = d->m_context->m_generator;
+		std::uniform_real_distribution< float > dis( 0.0f,
+			d->m_context->m_policy.leafAngle() );
 
 		d->m_leafDistRot = dis( gen );
 	}
@@ -260,18 +343,42 @@ Leaf::fallAndDie()
 {
 	d->m_fallAndDie = true;
 
-	d->m_fallVectorEndPos = *( d->m_endBranchPos );
+	// Falling leaf leaves the branch in the hierarchy of entities.
+	if( d->m_context->m_useHierarchy && d->m_context->m_leafsParent &&
+		d->m_branch )
+	{
+		d->m_fallVectorEndPos = d->m_branch->topMatrix().map( QVector3D() );
+
+		setParent( d->m_context->m_leafsParent );
+		setEnabled( true );
+	}
+	else
+		d->m_fallVectorEndPos = *( d->m_endBranchPos );
 
-	d->m_fallVectorStartPos = *( d->m_endBranchPos ) - QVector3D( 0.0f, 0.5f, 0.0f );
+	d->m_fallVectorStartPos = d->m_fallVectorEndPos - QVector3D( 0.0f, 0.5f, 0.0f );
 
 	d->m_startBranchPos = &( d->m_fallVectorStartPos );
 
 	d->m_endBranchPos = &( d->m_fallVectorEndPos );
 
+	// Falling leaf doesn't follow the branch in the next spring.
+	if( d->m_context->m_gpuGrowth )
+		d->m_material->setSpringOffset( QVector3D() );
+
 	connect( d->m_timer, &QTimer::timeout,
 		this, &Leaf::timeout );
 }
 
+QMatrix4x4
+Leaf::matrix() const
+{
+	// In the hierarchy of entities the leaf is on the branch till it falls.
+	if( d->m_context->m_useHierarchy && !d->m_fallAndDie && d->m_branch )
+		return d->m_branch->topMatrix() * d->m_transform->matrix();
+	else
+		return d->m_transform->matrix();
+}
+
 void
 Leaf::timeout()
 {
@@ -284,14 +391,17 @@ Leaf::timeout()
 	}
 	else
 	{
+		// Keep fall speed when the animation timer is slowed down.
+		const float k = (float) d->m_timer->interval() / c_fallBaseInterval;
+
 		rotate( d->m_fallAngle );
 
-		d->m_fallVectorEndPos -= QVector3D( 0.0f, 0.05f, 0.0f );
+		d->m_fallVectorEndPos -= QVector3D( 0.0f, 0.05f * k, 0.0f );
 
 		d->m_fallVectorStartPos = d->m_fallVectorEndPos -
 			QVector3D( 0.0f, 0.5f, 0.0f );
 
-		d->m_fallAngle += 15.0f;
+		d->m_fallAngle += 15.0f * k;
 
 		updatePosition();
 	}
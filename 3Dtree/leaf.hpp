@@ -25,20 +25,20 @@
 
 // Qt include.
 #include <Qt3DCore/QEntity>
+#include <QMatrix4x4>
+
+// C++ include.
+#include <memory>
+#include <random>
 
 QT_BEGIN_NAMESPACE
 
 class QColor;
 
-namespace Qt3DRender {
-	class QMesh;
-}
-
-class QTimer;
-
 QT_END_NAMESPACE
 
 class Branch;
+struct TreeContext;
 
 
 //
@@ -56,12 +56,9 @@ class Leaf Q_DECL_FINAL
 public:
 	Leaf( const QVector3D & startBranchPos,
 		const QVector3D & endBranchPos,
-		Qt3DRender::QMesh * mesh,
-		QTimer * animationTimer,
+		TreeContext * context,
 		Branch * parentBranch,
-		quint64 & entityCounter,
-		Qt3DCore::QNode * parent = Q_NULLPTR,
-		bool useInstanceRendering = false );
+		Qt3DCore::QNode * parent = Q_NULLPTR );
 	~Leaf();
 
 	//! Set color.
@@ -70,9 +67,21 @@ public:
 	//! Set age in range from 0.0 to 1.0.
 	void setAge( float age );
 
+	//! Let the shader grow, color and drop the leaf from the age of
+	//! the tree \par birthAge, setAge() and setColor() aren't used then.
+	void setSeason( float birthAge );
+
+	//! Set offset to the position at the start of the spring, see
+	//! TreeMaterial::setSpringOffset().
+	void setSpringOffset( const QVector3D & offset );
+
 	//! Update position of the leaf.
 	void updatePosition();
 
+	//! Replace position of the branch \par from the leaf is anchored
+	//! to with \par to.
+	void reanchor( const QVector3D * from, const QVector3D * to );
+
 	//! Rotate leaf. \note The leaf is rotated around the branch with
 	//! small random angle to the orthogonal plane to the branch.
 	//! \par angle is angle on the orthogonal to the branch plane with
@@ -80,11 +89,24 @@ public:
 	void rotate( float angle );
 
 	//! \return Autumn's color.
-	static QColor autumnColor();
+	static QColor autumnColor( std::mt19937 & gen );
+
+	//! \return Age of the leaf it turns color at. It's sampled at once
+	//! as the rolls on every tick of the context since the age \par from
+	//! give it: the leaf turns at age a with probability 0.12 / ( 0.75 - a )
+	//! per tick since 0.5, and for sure at 0.63.
+	static float turnAge( float from, TreeContext * context );
+
+	//! \return Age of the leaf it falls at: with probability
+	//! 0.01 / ( 0.97 - a ) per tick since 0.75, and for sure at 0.96.
+	static float fallAge( float from, TreeContext * context );
 
 	//! Animate fall of the leaf.
 	void fallAndDie();
 
+	//! \return Matrix of the leaf in the coordinates of the tree.
+	QMatrix4x4 matrix() const;
+
 private slots:
 	//! Timeout.
 	void timeout();
@@ -0,0 +1,119 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "leaf_budget.hpp"
+#include "branch.hpp"
+
+// C++ include.
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+
+//
+// LeafBudget
+//
+
+LeafBudget::LeafBudget()
+	:	m_limit( 0 )
+	,	m_count( 0 )
+{
+}
+
+LeafBudget::~LeafBudget()
+{
+}
+
+int
+LeafBudget::limit() const
+{
+	return m_limit;
+}
+
+void
+LeafBudget::setLimit( int limit )
+{
+	m_limit = qMax( 0, limit );
+}
+
+int
+LeafBudget::count() const
+{
+	return m_count;
+}
+
+void
+LeafBudget::addLeaf()
+{
+	++m_count;
+}
+
+void
+LeafBudget::removeLeaf()
+{
+	--m_count;
+}
+
+void
+LeafBudget::enqueue( Branch * branch )
+{
+	m_queue.append( branch );
+}
+
+void
+LeafBudget::distribute()
+{
+	QVector< std::pair< float, Branch* > > wanted;
+	wanted.reserve( m_queue.size() );
+
+	for( const auto & b : qAsConst( m_queue ) )
+	{
+		if( b && b->wantedLeafsCount() > 0 )
+			wanted.append( std::make_pair( b->leafsPriority(), b.data() ) );
+	}
+
+	std::stable_sort( wanted.begin(), wanted.end(),
+		[] ( const std::pair< float, Branch* > & a,
+			const std::pair< float, Branch* > & b )
+		{
+			return a.first > b.first;
+		} );
+
+	m_queue.clear();
+
+	int free = ( m_limit > 0 ? m_limit - m_count : std::numeric_limits< int >::max() );
+
+	for( const auto & w : qAsConst( wanted ) )
+	{
+		const int count = qMin( (int) w.second->wantedLeafsCount(), free );
+
+		if( count > 0 )
+		{
+			w.second->createLeafs( (quint8) count );
+
+			free -= count;
+		}
+		else
+			m_queue.append( w.second );
+	}
+}
@@ -0,0 +1,77 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__LEAF_BUDGET_HPP__INCLUDED
+#define TREE__LEAF_BUDGET_HPP__INCLUDED
+
+// Qt include.
+#include <QVector>
+#include <QPointer>
+
+class Branch;
+
+
+//
+// LeafBudget
+//
+
+//! Global cap on live leafs, shared by all trees. Branches don't create
+//! leafs at birth but wait in the queue, and on every simulation step
+//! free leafs are given to branches with the highest priority: terminal,
+//! outer branches of visible trees.
+class LeafBudget Q_DECL_FINAL {
+public:
+	LeafBudget();
+	~LeafBudget();
+
+	//! \return Max count of live leafs, 0 means unlimited.
+	int limit() const;
+	//! Set max count of live leafs. Live leafs over the new limit aren't
+	//! deleted, new ones are just not created.
+	void setLimit( int limit );
+
+	//! \return Count of live leafs.
+	int count() const;
+	//! Leaf was created.
+	void addLeaf();
+	//! Leaf was deleted.
+	void removeLeaf();
+
+	//! Put branch in the queue for leafs.
+	void enqueue( Branch * branch );
+
+	//! Give free leafs to queued branches by priority. Branches that
+	//! don't want leafs anymore leave the queue.
+	void distribute();
+
+private:
+	//! Max count of live leafs.
+	int m_limit;
+	//! Count of live leafs.
+	int m_count;
+	//! Branches waiting for leafs.
+	QVector< QPointer< Branch > > m_queue;
+
+	Q_DISABLE_COPY( LeafBudget )
+}; // class LeafBudget
+
+#endif // TREE__LEAF_BUDGET_HPP__INCLUDED
@@ -0,0 +1,209 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "lifecycle_scheduler.hpp"
+#include "branch.hpp"
+
+// C++ include.
+#include <algorithm>
+#include <utility>
+
+
+//
+// LifecycleScheduler
+//
+
+LifecycleScheduler::LifecycleScheduler()
+	:	m_time( 0.0f )
+	,	m_order( 0 )
+{
+}
+
+float
+LifecycleScheduler::time() const
+{
+	return m_time;
+}
+
+void
+LifecycleScheduler::setTime( float age )
+{
+	m_time = age;
+}
+
+void
+LifecycleScheduler::schedule( float delay, LifecycleEvent::Type type,
+	Branch * branch, Leaf * leaf )
+{
+	const LifecycleEvent e = { m_time + qMax( 0.0f, delay ), m_order++, type,
+		branch, leaf };
+
+	m_branches[ branch ].push_back( e.m_order );
+
+	m_events.push_back( e );
+	m_positions[ e.m_order ] = m_events.size() - 1;
+
+	siftUp( m_events.size() - 1 );
+}
+
+void
+LifecycleScheduler::cancel( Branch * branch )
+{
+	const auto it = m_branches.find( branch );
+
+	if( it == m_branches.end() )
+		return;
+
+	const std::vector< quint64 > orders = std::move( it->second );
+
+	m_branches.erase( it );
+
+	for( const auto & o : orders )
+	{
+		const auto pos = m_positions.find( o );
+
+		if( pos != m_positions.end() )
+			removeAt( pos->second );
+	}
+}
+
+void
+LifecycleScheduler::fire()
+{
+	while( !m_events.empty() && m_events.front().m_time <= m_time )
+	{
+		const LifecycleEvent e = m_events.front();
+
+		removeAt( 0 );
+		unlink( e );
+
+		// Handler may delete branches, their events are cancelled then.
+		e.m_branch->lifecycleEvent( e.m_type, e.m_leaf );
+	}
+}
+
+int
+LifecycleScheduler::count() const
+{
+	return (int) m_events.size();
+}
+
+bool
+LifecycleScheduler::earlier( const LifecycleEvent & a,
+	const LifecycleEvent & b )
+{
+	return ( a.m_time < b.m_time ||
+		( a.m_time == b.m_time && a.m_order < b.m_order ) );
+}
+
+void
+LifecycleScheduler::place( size_t pos, const LifecycleEvent & e )
+{
+	m_events[ pos ] = e;
+	m_positions[ e.m_order ] = pos;
+}
+
+void
+LifecycleScheduler::siftUp( size_t pos )
+{
+	const LifecycleEvent e = m_events[ pos ];
+
+	while( pos > 0 )
+	{
+		const size_t parent = ( pos - 1 ) / 2;
+
+		if( !earlier( e, m_events[ parent ] ) )
+			break;
+
+		place( pos, m_events[ parent ] );
+		pos = parent;
+	}
+
+	place( pos, e );
+}
+
+void
+LifecycleScheduler::siftDown( size_t pos )
+{
+	const LifecycleEvent e = m_events[ pos ];
+	const size_t size = m_events.size();
+
+	while( true )
+	{
+		size_t child = pos * 2 + 1;
+
+		if( child >= size )
+			break;
+
+		if( child + 1 < size && earlier( m_events[ child + 1 ],
+			m_events[ child ] ) )
+				++child;
+
+		if( !earlier( m_events[ child ], e ) )
+			break;
+
+		place( pos, m_events[ child ] );
+		pos = child;
+	}
+
+	place( pos, e );
+}
+
+void
+LifecycleScheduler::removeAt( size_t pos )
+{
+	m_positions.erase( m_events[ pos ].m_order );
+
+	const size_t last = m_events.size() - 1;
+
+	if( pos != last )
+	{
+		place( pos, m_events[ last ] );
+		m_events.pop_back();
+
+		// Last event may belong above or below the removed one.
+		if( pos > 0 && earlier( m_events[ pos ], m_events[ ( pos - 1 ) / 2 ] ) )
+			siftUp( pos );
+		else
+			siftDown( pos );
+	}
+	else
+		m_events.pop_back();
+}
+
+void
+LifecycleScheduler::unlink( const LifecycleEvent & e )
+{
+	const auto it = m_branches.find( e.m_branch );
+
+	if( it == m_branches.end() )
+		return;
+
+	auto & orders = it->second;
+
+	orders.erase( std::remove( orders.begin(), orders.end(), e.m_order ),
+		orders.end() );
+
+	if( orders.empty() )
+		m_branches.erase( it );
+}
@@ -0,0 +1,129 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__LIFECYCLE_SCHEDULER_HPP__INCLUDED
+#define TREE__LIFECYCLE_SCHEDULER_HPP__INCLUDED
+
+// Qt include.
+#include <QtGlobal>
+
+// C++ include.
+#include <unordered_map>
+#include <vector>
+
+class Branch;
+class Leaf;
+
+
+//
+// LifecycleEvent
+//
+
+//! Event in the life of the branch or its leaf.
+struct LifecycleEvent Q_DECL_FINAL {
+	//! Type of the event.
+	enum Type {
+		//! Branch dies.
+		BranchDeath,
+		//! Leaf turns autumn color.
+		LeafTurn,
+		//! Leaf falls.
+		LeafFall
+	}; // enum Type
+
+	//! Age of the tree the event is due on.
+	float m_time;
+	//! Order of scheduling, events due on the same age fire in this order.
+	quint64 m_order;
+	//! Type.
+	Type m_type;
+	//! Branch. Events are cancelled when the branch is deleted.
+	Branch * m_branch;
+	//! Leaf of the branch, the branch checks it's still its leaf.
+	Leaf * m_leaf;
+}; // struct LifecycleEvent
+
+
+//
+// LifecycleScheduler
+//
+
+//! Priority queue of lifecycle events of one tree. Times of events are
+//! sampled when branches and leafs are created, each tick fires only due
+//! events, so the cost of the tick doesn't depend on count of branches
+//! and leafs.
+//!
+//! Queue is an indexed binary heap: position of every event is known, so
+//! events of the deleted branch are removed from the heap at once and
+//! don't wait there for their time.
+class LifecycleScheduler Q_DECL_FINAL {
+public:
+	LifecycleScheduler();
+
+	//! \return Current age of the tree.
+	float time() const;
+
+	//! Set current age of the tree.
+	void setTime( float age );
+
+	//! Schedule event in \par delay years from now.
+	void schedule( float delay, LifecycleEvent::Type type, Branch * branch,
+		Leaf * leaf = Q_NULLPTR );
+
+	//! Cancel all pending events of the branch.
+	void cancel( Branch * branch );
+
+	//! Fire events due on the current age.
+	void fire();
+
+	//! \return Count of pending events.
+	int count() const;
+
+private:
+	//! \return Is event \par a due before \par b?
+	static bool earlier( const LifecycleEvent & a, const LifecycleEvent & b );
+	//! Place event at the position of the heap.
+	void place( size_t pos, const LifecycleEvent & e );
+	//! Move event up to its place.
+	void siftUp( size_t pos );
+	//! Move event down to its place.
+	void siftDown( size_t pos );
+	//! Remove event at the position of the heap.
+	void removeAt( size_t pos );
+	//! Forget event of the branch.
+	void unlink( const LifecycleEvent & e );
+
+	//! Heap of events, the earliest on top.
+	std::vector< LifecycleEvent > m_events;
+	//! Position in the heap by order of the event.
+	std::unordered_map< quint64, size_t > m_positions;
+	//! Orders of pending events by branch.
+	std::unordered_map< Branch*, std::vector< quint64 > > m_branches;
+	//! Current age of the tree.
+	float m_time;
+	//! Order of the next event.
+	quint64 m_order;
+
+	Q_DISABLE_COPY( LifecycleScheduler )
+}; // class LifecycleScheduler
+
+#endif // TREE__LIFECYCLE_SCHEDULER_HPP__INCLUDED
@@ -0,0 +1,393 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "lsystem.hpp"
+
+// Qt include.
+#include <QQuaternion>
+#include <QtConcurrent/QtConcurrentMap>
+
+// C++ include.
+#include <algorithm>
+
+
+//! Count of modules rewritten by one task.
+static const size_t c_chunkSize = 64 * 1024;
+//! Max count of modules in the string, growth stops on it.
+static const size_t c_maxModules = 8 * 1024 * 1024;
+//! Probability of the apex to stay dormant for a year.
+static const float c_dormancy = 0.1f;
+//! Probability of the apex to die.
+static const float c_apexDeath = 0.05f;
+
+
+//! \return Hash of the values.
+static inline quint32 mix( quint32 seed, quint32 a, quint32 b )
+{
+	quint32 h = seed ^ ( a * 0x9E3779B9u ) ^ ( b * 0x85EBCA6Bu );
+	h ^= h >> 16;
+	h *= 0x7FEB352Du;
+	h ^= h >> 15;
+	h *= 0x846CA68Bu;
+	h ^= h >> 16;
+
+	return h;
+}
+
+//! \return Random number in [0, 1) from the hash.
+static inline float unit( quint32 h )
+{
+	return (float) ( h >> 8 ) / 16777216.0f;
+}
+
+
+//
+// LSystemGrammar
+//
+
+LSystemGrammar::LSystemGrammar()
+{
+	m_table.fill( { 0, 0 } );
+}
+
+void
+LSystemGrammar::addProduction( char predecessor, const QByteArray & successor,
+	float weight )
+{
+	m_productions.push_back( { (quint8) predecessor, successor, weight } );
+}
+
+void
+LSystemGrammar::compile()
+{
+	std::stable_sort( m_productions.begin(), m_productions.end(),
+		[] ( const Production & a, const Production & b )
+			{ return a.m_predecessor < b.m_predecessor; } );
+
+	m_table.fill( { 0, 0 } );
+	m_successors.clear();
+	m_symbols.clear();
+
+	for( size_t i = 0; i < m_productions.size(); )
+	{
+		const quint8 p = m_productions[ i ].m_predecessor;
+
+		size_t last = i;
+		float sum = 0.0f;
+
+		for( ; last < m_productions.size() &&
+			m_productions[ last ].m_predecessor == p; ++last )
+				sum += m_productions[ last ].m_weight;
+
+		m_table[ p ] = { (quint32) m_successors.size(), (quint32) ( last - i ) };
+
+		float threshold = 0.0f;
+
+		for( ; i < last; ++i )
+		{
+			const auto & s = m_productions[ i ].m_successor;
+
+			threshold += ( sum > 0.0f ? m_productions[ i ].m_weight / sum : 1.0f );
+
+			m_successors.push_back( { (quint32) m_symbols.size(),
+				(quint32) s.size(), threshold } );
+
+			m_symbols.insert( m_symbols.end(), s.cbegin(), s.cend() );
+		}
+	}
+}
+
+qint32
+LSystemGrammar::successor( const LSystemModule & m, size_t pos, quint16 birth,
+	quint32 seed ) const
+{
+	const Entry & e = m_table[ m.m_symbol ];
+
+	if( !e.m_count )
+		return -1;
+	else if( e.m_count == 1 )
+		return (qint32) e.m_first;
+
+	const float r = unit( mix( seed ^ m.m_random, birth, (quint32) pos ) );
+
+	for( quint32 i = e.m_first, last = e.m_first + e.m_count; i < last; ++i )
+	{
+		if( r < m_successors[ i ].m_threshold )
+			return (qint32) i;
+	}
+
+	return (qint32) ( e.m_first + e.m_count - 1 );
+}
+
+bool
+LSystemGrammar::rewrite( const std::vector< LSystemModule > & str,
+	std::vector< LSystemModule > & out, quint16 birth, quint32 seed,
+	size_t limit ) const
+{
+	//! Range of the string rewritten by one task.
+	struct Chunk {
+		size_t m_begin;
+		size_t m_end;
+		//! Offset of the result in the output.
+		size_t m_offset;
+		//! Length of the result.
+		size_t m_length;
+	}; // struct Chunk
+
+	std::vector< Chunk > chunks;
+	chunks.reserve( str.size() / c_chunkSize + 1 );
+
+	for( size_t b = 0; b < str.size(); b += c_chunkSize )
+		chunks.push_back( { b, qMin( b + c_chunkSize, str.size() ), 0, 0 } );
+
+	auto run = [&chunks] ( auto func )
+	{
+		if( chunks.size() > 1 )
+			QtConcurrent::blockingMap( chunks, func );
+		else
+		{
+			for( auto & c : chunks )
+				func( c );
+		}
+	};
+
+	// Successors are chosen by the hash of the position, so both passes
+	// choose the same ones.
+	run( [&] ( Chunk & c )
+	{
+		size_t length = 0;
+
+		for( size_t i = c.m_begin; i < c.m_end; ++i )
+		{
+			const qint32 s = successor( str[ i ], i, birth, seed );
+
+			length += ( s < 0 ? 1 : m_successors[ s ].m_length );
+		}
+
+		c.m_length = length;
+	} );
+
+	size_t total = 0;
+
+	for( auto & c : chunks )
+	{
+		c.m_offset = total;
+		total += c.m_length;
+	}
+
+	if( total > limit )
+		return false;
+
+	std::vector< LSystemModule > res( total );
+
+	run( [&] ( Chunk & c )
+	{
+		LSystemModule * o = res.data() + c.m_offset;
+
+		for( size_t i = c.m_begin; i < c.m_end; ++i )
+		{
+			const qint32 s = successor( str[ i ], i, birth, seed );
+
+			if( s < 0 )
+				*o++ = str[ i ];
+			else
+			{
+				const Successor & succ = m_successors[ s ];
+
+				for( quint32 k = 0; k < succ.m_length; ++k )
+					*o++ = { m_symbols[ succ.m_offset + k ], birth,
+						mix( seed ^ str[ i ].m_random, (quint32) i, k ) };
+			}
+		}
+	} );
+
+	out.swap( res );
+
+	return true;
+}
+
+
+//
+// LSystemEngine
+//
+
+LSystemEngine::LSystemEngine( quint32 seed, const GrowthPolicy & policy )
+	:	m_policy( policy )
+	,	m_generation( 0 )
+	,	m_seed( seed )
+	,	m_pitch( 90.0f - policy.maxBranchAngle() / 2.0f )
+	,	m_roll( 0.0f )
+{
+	const int laterals = qMax( 1, (int) policy.childBranchesCount() -
+		( policy.hasContinuationBranch() ? 1 : 0 ) );
+
+	m_roll = 360.0f / (float) laterals;
+
+	QByteArray growth = "F";
+
+	for( int i = 0; i < laterals; ++i )
+		growth.append( "[&A]/" );
+
+	if( policy.hasContinuationBranch() )
+		growth.append( 'A' );
+
+	m_grammar.addProduction( 'A', growth,
+		1.0f - c_dormancy - c_apexDeath );
+	m_grammar.addProduction( 'A', "A", c_dormancy );
+	m_grammar.addProduction( 'A', "", c_apexDeath );
+	m_grammar.compile();
+
+	m_string.push_back( { 'A', 0, seed } );
+}
+
+void
+LSystemEngine::grow( int generation )
+{
+	if( generation <= m_generation )
+		return;
+
+	for( ; m_generation < generation; ++m_generation )
+	{
+		// Modules produced by the rewriting grow in the spring.
+		if( !m_grammar.rewrite( m_string, m_string,
+			(quint16) m_generation, m_seed, c_maxModules ) )
+				break;
+	}
+
+	m_generation = generation;
+
+	interpret();
+}
+
+const std::vector< GrowthNode > &
+LSystemEngine::nodes() const
+{
+	return m_nodes;
+}
+
+LSystemGrammar &
+LSystemEngine::grammar()
+{
+	return m_grammar;
+}
+
+const std::vector< LSystemModule > &
+LSystemEngine::string() const
+{
+	return m_string;
+}
+
+void
+LSystemEngine::interpret()
+{
+	//! State of the turtle.
+	struct State {
+		QQuaternion m_rotation;
+		//! Node the turtle is on, -1 for the ground.
+		qint32 m_node;
+		//! Is the turtle on the trunk?
+		bool m_trunk;
+	}; // struct State
+
+	std::vector< State > stack;
+	State s = { QQuaternion(), -1, true };
+
+	m_nodes.clear();
+
+	const QVector3D up( 0.0f, 1.0f, 0.0f );
+	const float distortion = m_policy.branchRotationDistortion() / 2.0f;
+
+	for( const auto & m : qAsConst( m_string ) )
+	{
+		// Angles are distorted by the random number of the module.
+		const float d = ( unit( m.m_random ) * 2.0f - 1.0f ) * distortion;
+
+		switch( m.m_symbol )
+		{
+			case 'F' :
+			{
+				GrowthNode n;
+				n.m_parent = s.m_node;
+				n.m_birth = (float) m.m_birth;
+				n.m_length = m_policy.branchLength() +
+					unit( m.m_random ) * m_policy.branchLengthDistortion();
+				n.m_bottomRadius = 0.0f;
+				n.m_topRadius = 0.0f;
+				n.m_direction = s.m_rotation.rotatedVector( up ).normalized();
+				n.m_startPos = ( s.m_node < 0 ? QVector3D() :
+					m_nodes[ s.m_node ].m_endPos );
+				n.m_endPos = n.m_startPos + n.m_direction * n.m_length;
+				n.m_isTree = s.m_trunk;
+				n.m_firstBranch = m_nodes.empty();
+				n.m_alive = true;
+
+				m_nodes.push_back( n );
+
+				s.m_node = (qint32) m_nodes.size() - 1;
+
+				if( n.m_parent >= 0 )
+					m_nodes[ n.m_parent ].m_children.push_back( s.m_node );
+			}
+				break;
+
+			case '&' :
+			case '^' :
+				s.m_rotation = s.m_rotation * QQuaternion::fromAxisAndAngle(
+					1.0f, 0.0f, 0.0f, ( m.m_symbol == '&' ? 1.0f : -1.0f ) *
+						( m_pitch + d ) );
+				break;
+
+			case '/' :
+			case '\\' :
+				s.m_rotation = s.m_rotation * QQuaternion::fromAxisAndAngle(
+					0.0f, 1.0f, 0.0f, ( m.m_symbol == '/' ? 1.0f : -1.0f ) *
+						( m_roll + d ) );
+				break;
+
+			case '+' :
+			case '-' :
+				s.m_rotation = s.m_rotation * QQuaternion::fromAxisAndAngle(
+					0.0f, 0.0f, 1.0f, ( m.m_symbol == '+' ? 1.0f : -1.0f ) *
+						( m_pitch + d ) );
+				break;
+
+			case '[' :
+				stack.push_back( s );
+				s.m_trunk = false;
+				break;
+
+			case ']' :
+				if( !stack.empty() )
+				{
+					s = stack.back();
+					stack.pop_back();
+				}
+				break;
+
+			default :
+				break;
+		}
+	}
+
+	applyPipeModel( m_nodes, qMax( 0.005f, m_policy.branchRadiusDelta() ) );
+}
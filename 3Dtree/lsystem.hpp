@@ -0,0 +1,170 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__LSYSTEM_HPP__INCLUDED
+#define TREE__LSYSTEM_HPP__INCLUDED
+
+// 3Dtree include.
+#include "growth_engine.hpp"
+
+// Qt include.
+#include <QByteArray>
+
+// C++ include.
+#include <array>
+#include <vector>
+
+
+//
+// LSystemModule
+//
+
+//! Module of the L-system string.
+struct LSystemModule Q_DECL_FINAL {
+	//! Symbol.
+	quint8 m_symbol;
+	//! Generation the module was produced in.
+	quint16 m_birth;
+	//! Random number of the module. It's kept while the module is copied,
+	//! so the turtle draws the same tree every generation.
+	quint32 m_random;
+}; // struct LSystemModule
+
+
+//
+// LSystemGrammar
+//
+
+//! Stochastic context-free L-system grammar. Productions are compiled
+//! into the table indexed by the symbol, symbols without productions
+//! are copied as is.
+class LSystemGrammar Q_DECL_FINAL {
+public:
+	LSystemGrammar();
+
+	//! Add production. Productions of the same predecessor are chosen
+	//! randomly by their weights.
+	void addProduction( char predecessor, const QByteArray & successor,
+		float weight = 1.0f );
+
+	//! Compile productions into the dispatch table.
+	void compile();
+
+	//! Rewrite \par str into \par out. Chunks of the string are rewritten
+	//! in parallel, modules get \par birth.
+	//! \return false if the result is longer than \par limit, \par out
+	//! isn't changed then.
+	bool rewrite( const std::vector< LSystemModule > & str,
+		std::vector< LSystemModule > & out, quint16 birth, quint32 seed,
+		size_t limit ) const;
+
+private:
+	//! \return Index of the successor of the module at the position,
+	//! -1 if the module is copied.
+	qint32 successor( const LSystemModule & m, size_t pos, quint16 birth,
+		quint32 seed ) const;
+
+	//! Production.
+	struct Production {
+		quint8 m_predecessor;
+		QByteArray m_successor;
+		float m_weight;
+	}; // struct Production
+
+	//! Compiled successor.
+	struct Successor {
+		//! Offset in the symbols.
+		quint32 m_offset;
+		//! Length.
+		quint32 m_length;
+		//! Successor is chosen if random number is less than this.
+		float m_threshold;
+	}; // struct Successor
+
+	//! Entry of the dispatch table.
+	struct Entry {
+		//! First successor.
+		quint32 m_first;
+		//! Count of successors.
+		quint32 m_count;
+	}; // struct Entry
+
+	//! Productions.
+	std::vector< Production > m_productions;
+	//! Dispatch table.
+	std::array< Entry, 256 > m_table;
+	//! Successors.
+	std::vector< Successor > m_successors;
+	//! Symbols of successors.
+	std::vector< quint8 > m_symbols;
+}; // class LSystemGrammar
+
+
+//
+// LSystemEngine
+//
+
+//! Grows the tree with the L-system built from the growth policy: every
+//! year an apex draws a segment and spawns lateral apexes, it may stay
+//! dormant or die. The string is interpreted by the turtle:
+//!
+//! F - segment, & and ^ - pitch down and up, / and \ - roll,
+//! + and - - yaw, [ and ] - push and pop the state of the turtle.
+class LSystemEngine Q_DECL_FINAL
+	:	public GrowthEngine
+{
+public:
+	LSystemEngine( quint32 seed, const GrowthPolicy & policy );
+
+	void grow( int generation ) Q_DECL_OVERRIDE;
+
+	const std::vector< GrowthNode > & nodes() const Q_DECL_OVERRIDE;
+
+	//! \return Grammar.
+	LSystemGrammar & grammar();
+
+	//! \return String of the current generation.
+	const std::vector< LSystemModule > & string() const;
+
+private:
+	//! Interpret the string with the turtle.
+	void interpret();
+
+	//! Policy.
+	GrowthPolicy m_policy;
+	//! Grammar.
+	LSystemGrammar m_grammar;
+	//! String.
+	std::vector< LSystemModule > m_string;
+	//! Nodes.
+	std::vector< GrowthNode > m_nodes;
+	//! Generation.
+	int m_generation;
+	//! Seed.
+	quint32 m_seed;
+	//! Pitch angle.
+	float m_pitch;
+	//! Roll angle.
+	float m_roll;
+}; // class LSystemEngine
+
+#endif // TREE__LSYSTEM_HPP__INCLUDED
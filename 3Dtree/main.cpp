@@ -22,16 +22,35 @@
 
 // Qt include.
 #include <QApplication>
+#include <QCommandLineParser>
 #include <Qt3DExtras/Qt3DWindow>
 
 // 3Dtree include.
 #include "mainwindow.hpp"
+#include "ensemble.hpp"
 
 
 int main( int argc, char ** argv )
 {
+	// Headless ensemble of trees, options are parsed by runEnsemble().
+	for( int i = 1; i < argc; ++i )
+	{
+		const QByteArray arg( argv[ i ] );
+
+		if( arg == "--ensemble" || arg.startsWith( "--ensemble=" ) )
+			return runEnsemble( argc, argv );
+	}
+
 	QApplication app( argc, argv );
 
+	// Qt options are taken by the application, the rest is rejected.
+	QCommandLineParser parser;
+	parser.setApplicationDescription(
+		QStringLiteral( "Grows trees. Run with --ensemble <seeds> to grow "
+			"headless trees and print statistics, see --ensemble --help." ) );
+	parser.addHelpOption();
+	parser.process( app );
+
 	auto view = std::make_unique< Qt3DExtras::Qt3DWindow > ();
 
 	MainWindow w( view );
@@ -22,9 +22,24 @@
 
 // 3Dtree include.
 #include "mainwindow.hpp"
-#include "branch.hpp"
+#include "forest.hpp"
+#include "tree.hpp"
 #include "constants.hpp"
 #include "camera_controller.hpp"
+#include "simulation_clock.hpp"
+#include "quality_governor.hpp"
+#include "tree_context.hpp"
+#include "growth_policy.hpp"
+#include "cone_cache.hpp"
+#include "packed_mesh.hpp"
+#include "change_counter.hpp"
+#include "tree_material.hpp"
+#include "leaf_budget.hpp"
+#include "branch_budget.hpp"
+#include "tree_exporter.hpp"
+#include "growth_engine.hpp"
+#include "simulation_thread.hpp"
+#include "sky_box.hpp"
 
 // Qt include.
 #include <QPushButton>
@@ -37,20 +52,43 @@
 #include <QFrame>
 #include <QVector>
 #include <QCheckBox>
+#include <QComboBox>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QFile>
+#include <QUrl>
 
 #include <Qt3DCore/QEntity>
 #include <Qt3DRender/QCamera>
-#include <Qt3DRender/QMesh>
 #include <Qt3DRender/QPointLight>
 #include <Qt3DCore/QTransform>
-#include <Qt3DExtras/QPhongMaterial>
 #include <Qt3DExtras/Qt3DWindow>
-#include <Qt3DExtras/QSkyboxEntity>
+#include <Qt3DRender/QTextureLoader>
+#include <Qt3DRender/QRenderSettings>
 #include <Qt3DLogic/QFrameAction>
 
+// C++ include.
+#include <random>
 
-//! Grow timer in milliseconds.
+
+//! Grow timer in milliseconds, i.e. default simulation step.
 static const int c_growTimer = 100;
+//! Maximum count of simulation steps processed per one frame.
+static const int c_maxSimulationSteps = 5;
+//! How long one year lasts in milliseconds.
+static const float c_yearDuration = 60.0f * 1000.0f;
+//! Default target FPS of the quality governor.
+static const int c_targetFps = 30;
+//! Default max count of live leafs.
+static const int c_leafsBudget = 20000;
+//! Default max count of live branches.
+static const int c_branchesBudget = 20000;
+//! Strength of the wind.
+static const float c_windStrength = 0.5f;
+//! Direction of the wind.
+static const QVector3D c_windDirection( 1.0f, 0.0f, 0.3f );
 
 
 //
@@ -60,34 +98,66 @@ static const int c_growTimer = 100;
 class MainWindowPrivate {
 public:
 	explicit MainWindowPrivate( MainWindow * parent )
-		:	m_tree( Q_NULLPTR )
-		,	m_growSpeed( 1.0f / 60.0f / ( 1000.0f / (float) c_growTimer ) )
+		:	m_growSpeed( (float) c_growTimer / c_yearDuration )
 		,	m_currentAge( 0.0f )
-		,	m_startPos( 0.0f, -0.5f, 0.0f )
-		,	m_endPos( 0.0f, 0.0f, 0.0f )
-		,	m_age( 0 )
+		,	m_prevAge( 0.0f )
+		,	m_clock( c_growTimer, c_maxSimulationSteps )
+		,	m_governor( c_targetFps )
 		,	m_years( Q_NULLPTR )
+		,	m_simulationStep( Q_NULLPTR )
 		,	m_btn( Q_NULLPTR )
 		,	m_timer( Q_NULLPTR )
 		,	m_secondTimer( Q_NULLPTR )
 		,	m_playing( true )
 		,	m_grown( true )
 		,	m_rootEntity( Q_NULLPTR )
+		,	m_camera( Q_NULLPTR )
+		,	m_frameAction( Q_NULLPTR )
+		,	m_renderSettings( Q_NULLPTR )
 		,	m_lightEntity( Q_NULLPTR )
+		,	m_effect( Q_NULLPTR )
 		,	m_branchMaterial( Q_NULLPTR )
 		,	m_leafMesh( Q_NULLPTR )
 		,	m_control( Q_NULLPTR )
 		,	m_light( Q_NULLPTR )
 		,	m_lightTransform( Q_NULLPTR )
 		,	m_skyBox( Q_NULLPTR )
+		,	m_skyBoxPlaceholder( Q_NULLPTR )
 		,	m_entityCounterLabel( Q_NULLPTR )
+		,	m_conesCountLabel( Q_NULLPTR )
+		,	m_leafsCountLabel( Q_NULLPTR )
 		,	m_fpsLabel( Q_NULLPTR )
 		,	m_markLabel( Q_NULLPTR )
 		,	m_avgFpsLabel( Q_NULLPTR )
 		,	m_useInstanceRendering( Q_NULLPTR )
 		,	m_enableDeath( Q_NULLPTR )
+		,	m_interpolate( Q_NULLPTR )
+		,	m_useTubes( Q_NULLPTR )
+		,	m_continuousRendering( Q_NULLPTR )
+		,	m_wind( Q_NULLPTR )
+		,	m_gpuGrowth( Q_NULLPTR )
+		,	m_consolidateChains( Q_NULLPTR )
+		,	m_useHierarchy( Q_NULLPTR )
+		,	m_countChanges( Q_NULLPTR )
+		,	m_changesLabel( Q_NULLPTR )
+		,	m_exportBenchmark( Q_NULLPTR )
+		,	m_exportTrees( Q_NULLPTR )
+		,	m_mergeExportedBranches( Q_NULLPTR )
+		,	m_adaptiveQuality( Q_NULLPTR )
+		,	m_targetFps( Q_NULLPTR )
+		,	m_qualityLabel( Q_NULLPTR )
+		,	m_forestMode( Q_NULLPTR )
+		,	m_treesCount( Q_NULLPTR )
+		,	m_placement( Q_NULLPTR )
+		,	m_visibleTreesLabel( Q_NULLPTR )
+		,	m_species( Q_NULLPTR )
+		,	m_engine( Q_NULLPTR )
+		,	m_loadPolicy( Q_NULLPTR )
+		,	m_leafsBudget( Q_NULLPTR )
+		,	m_branchesBudget( Q_NULLPTR )
 		,	m_entityCounter( 0 )
 		,	m_fps( 0 )
+		,	m_windTime( 0.0f )
 		,	m_secondsCounter( 0.0f )
 		,	m_totalFps( 0.0f )
 		,	m_totalEntitiesCount( 0.0f )
@@ -107,24 +177,41 @@ public:
 	void createTree();
 	//! Delete tree.
 	void deleteTree();
-
-	//! Tree.
-	Branch * m_tree;
+	//! Simulation step.
+	void simulationStep();
+	//! Set simulation step in milliseconds.
+	void setSimulationStep( int ms );
+	//! Apply quality chosen by the governor.
+	void applyQuality();
+	//! Render on demand if nothing is animated.
+	void updateRenderPolicy();
+	//! Update visibility of the forest for the camera.
+	void updateVisibility();
+	//! Create sky box.
+	SkyBox * createSkyBox( const QString & baseName,
+		Qt3DCore::QEntity * parent );
+
+	//! Forest, in single tree mode it has one tree.
+	Forest m_forest;
 	//! Grow speed.
 	float m_growSpeed;
 	//! Current age.
 	float m_currentAge;
-	//! Start tree pos.
-	QVector3D m_startPos;
-	//! End tree pos.
-	QVector3D m_endPos;
-	//! How old the tree?
-	quint16 m_age;
+	//! Age on the previous simulation step.
+	float m_prevAge;
+	//! Simulation clock.
+	SimulationClock m_clock;
+	//! Quality governor.
+	QualityGovernor m_governor;
+	//! Tree context.
+	TreeContext m_context;
 	//! Years.
 	QSpinBox * m_years;
+	//! Simulation step.
+	QSpinBox * m_simulationStep;
 	//! Pause/play button.
 	QPushButton * m_btn;
-	//! Timer.
+	//! Leafs animation timer.
 	QTimer * m_timer;
 	//! Second timer.
 	QTimer * m_secondTimer;
@@ -134,12 +221,20 @@ public:
 	bool m_grown;
 	//! Root entity.
 	Qt3DCore::QEntity * m_rootEntity;
+	//! Camera.
+	Qt3DRender::QCamera * m_camera;
+	//! Frame action driving the simulation.
+	Qt3DLogic::QFrameAction * m_frameAction;
+	//! Render settings.
+	Qt3DRender::QRenderSettings * m_renderSettings;
 	//! Light.
 	Qt3DCore::QEntity * m_lightEntity;
+	//! Effect of branches and leafs.
+	TreeEffect * m_effect;
 	//! Branch material.
-	Qt3DExtras::QPhongMaterial * m_branchMaterial;
+	TreeMaterial * m_branchMaterial;
 	//! Leaf mesh.
-	Qt3DRender::QMesh * m_leafMesh;
+	Qt3DRender::QGeometryRenderer * m_leafMesh;
 	//! Camera controller.
 	CameraController * m_control;
 	//! Light point.
@@ -147,9 +242,15 @@ public:
 	//! Light transform.
 	Qt3DCore::QTransform * m_lightTransform;
 	//! Sky box.
-	Qt3DExtras::QSkyboxEntity * m_skyBox;
+	SkyBox * m_skyBox;
+	//! Low resolution sky box shown while the full one is loading.
+	SkyBox * m_skyBoxPlaceholder;
 	//! Entity counter label.
 	QLabel * m_entityCounterLabel;
+	//! Count of branch meshes label.
+	QLabel * m_conesCountLabel;
+	//! Count of leafs label.
+	QLabel * m_leafsCountLabel;
 	//! FPS label.
 	QLabel * m_fpsLabel;
 	//! Mark label.
@@ -160,10 +261,64 @@ public:
 	QCheckBox * m_useInstanceRendering;
 	//! Enable death?
 	QCheckBox * m_enableDeath;
+	//! Interpolate transforms between simulation steps?
+	QCheckBox * m_interpolate;
+	//! Draw continuation chains with tubes?
+	QCheckBox * m_useTubes;
+	//! Render every frame, even if nothing changes?
+	QCheckBox * m_continuousRendering;
+	//! Wind?
+	QCheckBox * m_wind;
+	//! Evaluate growth in the shader?
+	QCheckBox * m_gpuGrowth;
+	//! Merge old continuation chains?
+	QCheckBox * m_consolidateChains;
+	//! Inherit transforms through the hierarchy of entities?
+	QCheckBox * m_useHierarchy;
+	//! Count property changes?
+	QCheckBox * m_countChanges;
+	//! Property changes label.
+	QLabel * m_changesLabel;
+	//! Export benchmark button.
+	QPushButton * m_exportBenchmark;
+	//! Export trees button.
+	QPushButton * m_exportTrees;
+	//! Merge branches on export?
+	QCheckBox * m_mergeExportedBranches;
+	//! Counter of property changes.
+	ChangeCounter m_changeCounter;
+	//! Adaptive quality?
+	QCheckBox * m_adaptiveQuality;
+	//! Target FPS.
+	QSpinBox * m_targetFps;
+	//! Quality label.
+	QLabel * m_qualityLabel;
+	//! Forest mode?
+	QCheckBox * m_forestMode;
+	//! Count of trees in the forest.
+	QSpinBox * m_treesCount;
+	//! Placement of the trees.
+	QComboBox * m_placement;
+	//! Visible trees label.
+	QLabel * m_visibleTreesLabel;
+	//! Species.
+	QComboBox * m_species;
+	//! Load policy button.
+	QPushButton * m_loadPolicy;
+	//! Growth engine.
+	QComboBox * m_engine;
+	//! Policies of the species combo box.
+	QVector< GrowthPolicy > m_policies;
+	//! Max count of live leafs.
+	QSpinBox * m_leafsBudget;
+	//! Max count of live branches.
+	QSpinBox * m_branchesBudget;
 	//! Entity counter.
 	quint64 m_entityCounter;
 	//! FPS.
 	int m_fps;
+	//! Time of the wind in seconds.
+	float m_windTime;
 	//! Seconds count.
 	double m_secondsCounter;
 	//! Total FPS.
@@ -202,6 +357,19 @@ MainWindowPrivate::init( std::unique_ptr< Qt3DExtras::Qt3DWindow > & view )
 	m_years->setValue( 5 );
 	l1->addWidget( m_years );
 
+	QHBoxLayout * l2 = new QHBoxLayout;
+	v->addLayout( l2 );
+
+	QLabel * stepLabel = new QLabel( MainWindow::tr( "Simulation Step, ms" ), q );
+	l2->addWidget( stepLabel );
+
+	m_simulationStep = new QSpinBox( q );
+	m_simulationStep->setMinimum( 10 );
+	m_simulationStep->setMaximum( 1000 );
+	m_simulationStep->setSingleStep( 10 );
+	m_simulationStep->setValue( c_growTimer );
+	l2->addWidget( m_simulationStep );
+
 	m_useInstanceRendering = new QCheckBox( MainWindow::tr( "Use Instanced Rendering" ), q );
 	m_useInstanceRendering->setChecked( false );
 	v->addWidget( m_useInstanceRendering );
@@ -210,9 +378,149 @@ MainWindowPrivate::init( std::unique_ptr< Qt3DExtras::Qt3DWindow > & view )
 	m_enableDeath->setChecked( true );
 	v->addWidget( m_enableDeath );
 
+	m_interpolate = new QCheckBox( MainWindow::tr( "Interpolate Transforms" ), q );
+	m_interpolate->setChecked( true );
+	v->addWidget( m_interpolate );
+
+	m_useTubes = new QCheckBox( MainWindow::tr( "Continuous Branches" ), q );
+	m_useTubes->setChecked( false );
+	v->addWidget( m_useTubes );
+
+	m_continuousRendering = new QCheckBox(
+		MainWindow::tr( "Continuous Rendering" ), q );
+	m_continuousRendering->setChecked( false );
+	v->addWidget( m_continuousRendering );
+
+	m_wind = new QCheckBox( MainWindow::tr( "Wind" ), q );
+	m_wind->setChecked( false );
+	v->addWidget( m_wind );
+
+	m_gpuGrowth = new QCheckBox( MainWindow::tr( "Grow on GPU" ), q );
+	m_gpuGrowth->setChecked( false );
+	v->addWidget( m_gpuGrowth );
+
+	m_consolidateChains = new QCheckBox(
+		MainWindow::tr( "Merge Old Branches" ), q );
+	m_consolidateChains->setChecked( false );
+	v->addWidget( m_consolidateChains );
+
+	m_useHierarchy = new QCheckBox( MainWindow::tr( "Entity Hierarchy" ), q );
+	m_useHierarchy->setChecked( false );
+	v->addWidget( m_useHierarchy );
+
+	m_adaptiveQuality = new QCheckBox( MainWindow::tr( "Adaptive Quality" ), q );
+	m_adaptiveQuality->setChecked( false );
+	v->addWidget( m_adaptiveQuality );
+
+	QHBoxLayout * l3 = new QHBoxLayout;
+	v->addLayout( l3 );
+
+	QLabel * fpsLabel = new QLabel( MainWindow::tr( "Target FPS" ), q );
+	l3->addWidget( fpsLabel );
+
+	m_targetFps = new QSpinBox( q );
+	m_targetFps->setMinimum( 5 );
+	m_targetFps->setMaximum( 240 );
+	m_targetFps->setValue( c_targetFps );
+	l3->addWidget( m_targetFps );
+
+	m_forestMode = new QCheckBox( MainWindow::tr( "Forest Mode" ), q );
+	m_forestMode->setChecked( false );
+	v->addWidget( m_forestMode );
+
+	QHBoxLayout * l4 = new QHBoxLayout;
+	v->addLayout( l4 );
+
+	QLabel * treesLabel = new QLabel( MainWindow::tr( "Trees" ), q );
+	l4->addWidget( treesLabel );
+
+	m_treesCount = new QSpinBox( q );
+	m_treesCount->setMinimum( 2 );
+	m_treesCount->setMaximum( 1000 );
+	m_treesCount->setValue( 100 );
+	l4->addWidget( m_treesCount );
+
+	m_placement = new QComboBox( q );
+	m_placement->addItem( MainWindow::tr( "Grid" ), Forest::Grid );
+	m_placement->addItem( MainWindow::tr( "Scatter" ), Forest::Scatter );
+	l4->addWidget( m_placement );
+
+	QHBoxLayout * l5 = new QHBoxLayout;
+	v->addLayout( l5 );
+
+	QLabel * speciesLabel = new QLabel( MainWindow::tr( "Species" ), q );
+	l5->addWidget( speciesLabel );
+
+	m_species = new QComboBox( q );
+
+	for( const auto & name : GrowthPolicy::builtInNames() )
+	{
+		m_species->addItem( name );
+		m_policies.append( GrowthPolicy::builtIn( name ) );
+	}
+
+	l5->addWidget( m_species );
+
+	m_loadPolicy = new QPushButton( MainWindow::tr( "Load..." ), q );
+	l5->addWidget( m_loadPolicy );
+
+	QHBoxLayout * engineLayout = new QHBoxLayout;
+	v->addLayout( engineLayout );
+
+	QLabel * engineLabel = new QLabel( MainWindow::tr( "Growth Engine" ), q );
+	engineLayout->addWidget( engineLabel );
+
+	m_engine = new QComboBox( q );
+	m_engine->addItems( GrowthEngine::names() );
+	engineLayout->addWidget( m_engine );
+
+	QHBoxLayout * l6 = new QHBoxLayout;
+	v->addLayout( l6 );
+
+	QLabel * leafsBudgetLabel = new QLabel( MainWindow::tr( "Leafs Budget" ), q );
+	l6->addWidget( leafsBudgetLabel );
+
+	m_leafsBudget = new QSpinBox( q );
+	m_leafsBudget->setMinimum( 0 );
+	m_leafsBudget->setMaximum( 1000000 );
+	m_leafsBudget->setSingleStep( 1000 );
+	m_leafsBudget->setSpecialValueText( MainWindow::tr( "Unlimited" ) );
+	m_leafsBudget->setValue( c_leafsBudget );
+	l6->addWidget( m_leafsBudget );
+
+	QHBoxLayout * l7 = new QHBoxLayout;
+	v->addLayout( l7 );
+
+	QLabel * branchesBudgetLabel = new QLabel(
+		MainWindow::tr( "Branches Budget" ), q );
+	l7->addWidget( branchesBudgetLabel );
+
+	m_branchesBudget = new QSpinBox( q );
+	m_branchesBudget->setMinimum( 0 );
+	m_branchesBudget->setMaximum( 1000000 );
+	m_branchesBudget->setSingleStep( 1000 );
+	m_branchesBudget->setSpecialValueText( MainWindow::tr( "Unlimited" ) );
+	m_branchesBudget->setValue( c_branchesBudget );
+	l7->addWidget( m_branchesBudget );
+
+	m_countChanges = new QCheckBox( MainWindow::tr( "Count Property Changes" ), q );
+	m_countChanges->setChecked( false );
+	v->addWidget( m_countChanges );
+
 	m_btn = new QPushButton( MainWindow::tr( "Play" ), q );
 	v->addWidget( m_btn );
 
+	m_exportBenchmark = new QPushButton( MainWindow::tr( "Export Benchmark..." ), q );
+	v->addWidget( m_exportBenchmark );
+
+	m_mergeExportedBranches = new QCheckBox(
+		MainWindow::tr( "Merge Exported Branches" ), q );
+	m_mergeExportedBranches->setChecked( true );
+	v->addWidget( m_mergeExportedBranches );
+
+	m_exportTrees = new QPushButton( MainWindow::tr( "Export Trees..." ), q );
+	v->addWidget( m_exportTrees );
+
 	QFrame * line = new QFrame( q );
 	line->setFrameStyle( QFrame::HLine | QFrame::Sunken );
 	v->addWidget( line );
@@ -222,6 +530,14 @@ MainWindowPrivate::init( std::unique_ptr< Qt3DExtras::Qt3DWindow > & view )
 		.arg( m_entityCounter ) );
 	v->addWidget( m_entityCounterLabel );
 
+	m_conesCountLabel = new QLabel( q );
+	m_conesCountLabel->setText( MainWindow::tr( "Branch Meshes: %1" ).arg( 0 ) );
+	v->addWidget( m_conesCountLabel );
+
+	m_leafsCountLabel = new QLabel( q );
+	m_leafsCountLabel->setText( MainWindow::tr( "Leafs: %1" ).arg( 0 ) );
+	v->addWidget( m_leafsCountLabel );
+
 	m_fpsLabel = new QLabel( q );
 	m_fpsLabel->setText( MainWindow::tr( "FPS: %1" ).arg( 0 ) );
 	v->addWidget( m_fpsLabel );
@@ -234,6 +550,19 @@ MainWindowPrivate::init( std::unique_ptr< Qt3DExtras::Qt3DWindow > & view )
 	m_avgFpsLabel->setText( MainWindow::tr( "Avg. FPS: 0" ) );
 	v->addWidget( m_avgFpsLabel );
 
+	m_qualityLabel = new QLabel( q );
+	m_qualityLabel->setWordWrap( true );
+	m_qualityLabel->setText( MainWindow::tr( "Quality: full" ) );
+	v->addWidget( m_qualityLabel );
+
+	m_visibleTreesLabel = new QLabel( q );
+	m_visibleTreesLabel->setText( MainWindow::tr( "Visible Trees: %1" ).arg( 0 ) );
+	v->addWidget( m_visibleTreesLabel );
+
+	m_changesLabel = new QLabel( q );
+	m_changesLabel->setWordWrap( true );
+	v->addWidget( m_changesLabel );
+
 	QSpacerItem * s = new QSpacerItem( 10, 10, QSizePolicy::Minimum,
 		QSizePolicy::Expanding );
 
@@ -243,6 +572,9 @@ MainWindowPrivate::init( std::unique_ptr< Qt3DExtras::Qt3DWindow > & view )
 	m_timer->setInterval( c_growTimer );
 	m_timer->start();
 
+	m_context.m_animationTimer = m_timer;
+	m_context.m_entityCounter = &m_entityCounter;
+
 	m_secondTimer = new QTimer( q );
 	m_secondTimer->start( 1000 );
 
@@ -250,10 +582,34 @@ MainWindowPrivate::init( std::unique_ptr< Qt3DExtras::Qt3DWindow > & view )
 		q, &MainWindow::second );
 	MainWindow::connect( m_btn, &QPushButton::clicked,
 		q, &MainWindow::buttonClicked );
-	MainWindow::connect( m_timer, &QTimer::timeout,
-		q, &MainWindow::timer );
+	MainWindow::connect( m_simulationStep,
+		QOverload< int >::of( &QSpinBox::valueChanged ),
+		q, &MainWindow::simulationStepChanged );
+	MainWindow::connect( m_loadPolicy, &QPushButton::clicked,
+		q, &MainWindow::loadPolicyClicked );
+	MainWindow::connect( m_exportBenchmark, &QPushButton::clicked,
+		q, &MainWindow::exportBenchmarkClicked );
+	MainWindow::connect( m_exportTrees, &QPushButton::clicked,
+		q, &MainWindow::exportTreesClicked );
+	MainWindow::connect( m_continuousRendering, &QCheckBox::toggled,
+		q, &MainWindow::continuousRenderingToggled );
+	MainWindow::connect( m_wind, &QCheckBox::toggled,
+		q, &MainWindow::windToggled );
+	MainWindow::connect( m_adaptiveQuality, &QCheckBox::toggled,
+		q, &MainWindow::adaptiveQualityToggled );
+	MainWindow::connect( m_leafsBudget,
+		QOverload< int >::of( &QSpinBox::valueChanged ),
+		q, &MainWindow::leafsBudgetChanged );
+	MainWindow::connect( m_branchesBudget,
+		QOverload< int >::of( &QSpinBox::valueChanged ),
+		q, &MainWindow::branchesBudgetChanged );
+	MainWindow::connect( m_targetFps,
+		QOverload< int >::of( &QSpinBox::valueChanged ),
+		q, &MainWindow::targetFpsChanged );
 
 	init3D( window );
+
+	updateRenderPolicy();
 }
 
 void MainWindowPrivate::init3D( Qt3DExtras::Qt3DWindow * view )
@@ -266,18 +622,43 @@ void MainWindowPrivate::init3D( Qt3DExtras::Qt3DWindow * view )
 	QObject::connect( frameAction.get(), &Qt3DLogic::QFrameAction::triggered,
 		q, &MainWindow::frameProcessed );
 
+	m_frameAction = frameAction.get();
+
 	root->addComponent( frameAction.release() );
 
-	m_branchMaterial = new Qt3DExtras::QPhongMaterial( root.get() );
+	m_renderSettings = view->renderSettings();
+
+	m_effect = new TreeEffect( root.get() );
+	m_effect->setWind( c_windDirection, 0.0f );
 
-	m_leafMesh = new Qt3DRender::QMesh( root.get() );
-	m_leafMesh->setSource( QUrl( "qrc:/res/leaf.obj" ) );
+	m_branchMaterial = new TreeMaterial( m_effect, root.get() );
+
+	m_leafMesh = new PackedMesh( c_leafMeshData, root.get() );
 
 	m_branchMaterial->setDiffuse( QColor( 41, 19, 0 ) );
 
+	m_context.m_effect = m_effect;
+	m_context.m_material = m_branchMaterial;
+	m_context.m_leafMesh = m_leafMesh;
+	m_context.m_coneCache = std::make_shared< ConeCache > ( root.get() );
+	m_context.m_leafBudget = std::make_shared< LeafBudget > ();
+	m_context.m_leafBudget->setLimit( m_leafsBudget->value() );
+	m_context.m_branchBudget = std::make_shared< BranchBudget > ();
+	m_context.m_branchBudget->setLimit( m_branchesBudget->value() );
+	m_context.m_simulationThread = std::make_shared< SimulationThread > ();
+	m_context.m_simulationThread->start();
+
 	// Camera
 	Qt3DRender::QCamera * cameraEntity = view->camera();
 
+	m_camera = cameraEntity;
+
+	// Camera moves only on input, so visibility is updated on its changes.
+	QObject::connect( cameraEntity, &Qt3DRender::QCamera::viewMatrixChanged,
+		q, [this] () { updateVisibility(); } );
+	QObject::connect( cameraEntity, &Qt3DRender::QCamera::projectionMatrixChanged,
+		q, [this] () { updateVisibility(); } );
+
 	cameraEntity->lens()->setPerspectiveProjection(
 		45.0f, 16.0f / 9.0f, 0.1f, 1000.0f );
 	cameraEntity->setPosition( QVector3D( 0.0f, 5.0f, 20.0f ) );
@@ -299,22 +680,61 @@ void MainWindowPrivate::init3D( Qt3DExtras::Qt3DWindow * view )
 	m_lightTransform->setTranslation( cameraEntity->position() );
 	m_lightEntity->addComponent( m_lightTransform );
 
+	m_effect->setLightPosition( m_lightTransform->translation() );
+	m_effect->setLightIntensity( m_light->intensity() );
+
 	m_control = new CameraController( cameraEntity, root.get() );
 
-	m_skyBox = new Qt3DExtras::QSkyboxEntity( root.get() );
-	m_skyBox->setBaseName( QStringLiteral( "qrc:/res/skybox" ) );
-	m_skyBox->setExtension( QStringLiteral( ".tga" ) );
+	// Tiny placeholder is shown at once, the full sky box replaces it
+	// when its texture is loaded by Qt3D in the background.
+	m_skyBoxPlaceholder = createSkyBox( QStringLiteral( "qrc:/res/skybox_low" ),
+		root.get() );
+
+	m_skyBox = createSkyBox( QStringLiteral( "qrc:/res/skybox" ), root.get() );
+	m_skyBox->setEnabled( false );
+
+	QObject::connect( m_skyBox->texture(),
+		&Qt3DRender::QAbstractTexture::statusChanged,
+		q, [this] ( Qt3DRender::QAbstractTexture::Status status )
+		{
+			if( !m_skyBoxPlaceholder || !m_skyBox )
+				return;
+
+			if( status == Qt3DRender::QAbstractTexture::Ready )
+			{
+				m_skyBox->setEnabled( true );
+
+				m_skyBoxPlaceholder->deleteLater();
+				m_skyBoxPlaceholder = Q_NULLPTR;
+			}
+			// Placeholder stays if the full sky box can't be loaded.
+			else if( status == Qt3DRender::QAbstractTexture::Error )
+			{
+				m_skyBox->deleteLater();
+				m_skyBox = Q_NULLPTR;
+			}
+		} );
+
+	m_rootEntity = root.get();
+
+	view->setRootEntity( root.release() );
+}
+
+SkyBox *
+MainWindowPrivate::createSkyBox( const QString & baseName,
+	Qt3DCore::QEntity * parent )
+{
+	auto * skyBox = new SkyBox( QUrl( baseName + QStringLiteral( ".dds" ) ),
+		parent );
 
 	const float baseScale = 0.1f;
 
-	Qt3DCore::QTransform * skyTransform = new Qt3DCore::QTransform( m_skyBox );
+	Qt3DCore::QTransform * skyTransform = new Qt3DCore::QTransform( skyBox );
 	skyTransform->setTranslation( QVector3D( 0.0f, baseScale / 8.0f - 0.001f, 0.0f ) );
 	skyTransform->setScale3D( QVector3D( baseScale, baseScale / 4.0f, baseScale ) );
-	m_skyBox->addComponent( skyTransform );
+	skyBox->addComponent( skyTransform );
 
-	m_rootEntity = root.get();
-
-	view->setRootEntity( root.release() );
+	return skyBox;
 }
 
 void
@@ -327,30 +747,156 @@ MainWindowPrivate::createTree()
 	else
 		m_leafMesh->setInstanceCount( 1 );
 
-	m_age = 0;
+	m_context.m_useInstanceRendering = m_useInstanceRendering->isChecked();
+	m_context.m_enableDeath = m_enableDeath->isChecked();
+	m_context.m_ticksPerYear = 1.0f / m_growSpeed;
+	m_context.m_engine = static_cast< GrowthEngine::Type > (
+		m_engine->currentIndex() );
+
+	// Skeleton of the engine is flat and grows on the CPU.
+	const bool branches = ( m_context.m_engine == GrowthEngine::Branches );
+
+	m_context.m_useHierarchy = ( m_useHierarchy->isChecked() && branches );
+	m_context.m_useTubes = ( m_useTubes->isChecked() &&
+		!m_context.m_useHierarchy && branches );
+	m_context.m_gpuGrowth = ( m_gpuGrowth->isChecked() &&
+		!m_context.m_useTubes && !m_context.m_useHierarchy && branches );
+	m_context.m_gpuSeasons = m_gpuGrowth->isChecked();
+	m_context.m_consolidateChains = ( m_consolidateChains->isChecked() &&
+		!m_context.m_gpuGrowth && !m_context.m_useHierarchy && branches );
+	m_context.m_changeCounter = ( m_countChanges->isChecked() ?
+		&m_changeCounter : Q_NULLPTR );
+
+	m_changeCounter.reset();
+	m_changesLabel->clear();
+	m_context.m_policy = m_policies.at( m_species->currentIndex() );
+
+	m_effect->setPolicy( m_context.m_policy );
+	m_effect->setAge( 0.0f );
 
-	m_tree = new Branch( m_startPos, m_endPos, m_age,
-		c_startBranchRadius,
-		true, true,
-		m_branchMaterial, m_leafMesh,
-		m_timer, Q_NULLPTR, m_entityCounter, m_rootEntity, true,
-		m_useInstanceRendering->isChecked(),
-		m_enableDeath->isChecked() );
+	std::random_device rd;
 
-	m_tree->setAge( 0.0f );
-	m_tree->updatePosition();
-	m_tree->placeLeafs();
+	m_forest.create( m_forestMode->isChecked() ? m_treesCount->value() : 1,
+		static_cast< Forest::Placement > ( m_placement->currentData().toInt() ),
+		rd(), m_context, m_rootEntity );
+
+	updateVisibility();
 }
 
 void
-MainWindowPrivate::deleteTree()
+MainWindowPrivate::updateRenderPolicy()
+{
+	const bool continuous = m_continuousRendering->isChecked();
+
+	// Without simulation frames are rendered only when the scene changes,
+	// i.e. camera moves or the sky box is loaded.
+	m_renderSettings->setRenderPolicy( continuous ?
+		Qt3DRender::QRenderSettings::Always :
+		Qt3DRender::QRenderSettings::OnDemand );
+
+	m_frameAction->setEnabled( continuous || m_wind->isChecked() ||
+		( m_playing && !m_grown ) );
+}
+
+void
+MainWindowPrivate::updateVisibility()
 {
-	if( m_tree )
+	m_forest.updateVisibility( m_camera->projectionMatrix() *
+		m_camera->viewMatrix(), m_camera->position() );
+}
+
+void
+MainWindowPrivate::setSimulationStep( int ms )
+{
+	ms *= m_context.m_quality.m_simulationMultiplier;
+
+	m_clock.setStep( ms );
+
+	m_growSpeed = (float) ms / c_yearDuration;
+
+	m_context.m_ticksPerYear = 1.0f / m_growSpeed;
+
+	for( auto * t : m_forest.trees() )
+		t->context().m_ticksPerYear = m_context.m_ticksPerYear;
+}
+
+void
+MainWindowPrivate::applyQuality()
+{
+	const Quality quality = ( m_adaptiveQuality->isChecked() ?
+		m_governor.quality() : Quality::full() );
+
+	if( quality == m_context.m_quality )
+		return;
+
+	m_forest.setQuality( quality );
+
+	m_context.m_quality = quality;
+
+	m_timer->setInterval( c_growTimer * quality.m_animationMultiplier );
+
+	setSimulationStep( m_simulationStep->value() );
+
+	const QStringList knobs = ( m_adaptiveQuality->isChecked() ?
+		m_governor.reducedKnobs() : QStringList() );
+
+	if( knobs.isEmpty() )
+		m_qualityLabel->setText( MainWindow::tr( "Quality: full" ) );
+	else
+		m_qualityLabel->setText( MainWindow::tr( "Quality: reduced %1" )
+			.arg( knobs.join( QStringLiteral( ", " ) ) ) );
+}
+
+void
+MainWindowPrivate::simulationStep()
+{
+	m_prevAge = m_currentAge;
+	m_currentAge += m_growSpeed;
+
+	m_changeCounter.tick();
+
+	if( m_currentAge > (float) m_years->value() - 0.5f )
 	{
-		m_tree->deleteLater();
+		m_currentAge = m_prevAge;
+
+		m_timer->stop();
+
+		m_grown = true;
+
+		m_btn->setText( MainWindow::tr( "Restart" ) );
+
+		m_playing = false;
 
-		m_tree = Q_NULLPTR;
+		updateRenderPolicy();
 	}
+	else
+	{
+		m_forest.setAge( m_currentAge );
+
+		// Pruned branches free leafs for the rest.
+		m_context.m_branchBudget->prune( m_forest.trees(), m_currentAge );
+		m_context.m_leafBudget->distribute();
+	}
+
+	m_entityCounterLabel->setText( MainWindow::tr( "Entities Count: %1" )
+		.arg( m_entityCounter ) );
+
+	m_conesCountLabel->setText( MainWindow::tr( "Branch Meshes: %1" )
+		.arg( m_context.m_coneCache->count() ) );
+
+	m_leafsCountLabel->setText( MainWindow::tr( "Leafs: %1" )
+		.arg( m_context.m_leafBudget->count() ) );
+
+	q->calcMark();
+
+	m_avgFpsLabel->setText( MainWindow::tr( "Avg. FPS: %1" )
+		.arg( QString::number( m_totalFps / m_secondsCounter, 'f', 2 ) ) );
+}
+
+void
+MainWindowPrivate::deleteTree()
+{
+	m_forest.clear();
 }
 
 
@@ -380,6 +926,12 @@ MainWindow::buttonClicked()
 		d->m_btn->setText( tr( "Pause" ) );
 
 		d->m_currentAge = 0.0f;
+		d->m_prevAge = 0.0f;
+
+		d->m_clock.reset();
+
+		d->m_governor.reset();
+		d->applyQuality();
 
 		d->createTree();
 
@@ -407,39 +959,91 @@ MainWindow::buttonClicked()
 
 		d->m_timer->start();
 	}
+
+	d->updateRenderPolicy();
 }
 
 void
-MainWindow::timer()
+MainWindow::continuousRenderingToggled( bool )
 {
-	d->m_currentAge += d->m_growSpeed;
+	d->updateRenderPolicy();
+}
 
-	if( d->m_currentAge > (float) d->m_years->value() - 0.5f )
-	{
-		d->m_timer->stop();
+void
+MainWindow::windToggled( bool on )
+{
+	d->m_effect->setWind( c_windDirection,
+		on ? c_windStrength : 0.0f );
 
-		d->m_grown = true;
+	d->updateRenderPolicy();
+}
 
-		d->m_btn->setText( tr( "Restart" ) );
+void
+MainWindow::simulationStepChanged( int ms )
+{
+	d->setSimulationStep( ms );
+}
 
-		d->m_playing = false;
-	}
-	else if( d->m_tree )
-		d->m_tree->setAge( d->m_currentAge );
+void
+MainWindow::adaptiveQualityToggled( bool )
+{
+	d->m_governor.reset();
+	d->applyQuality();
+}
 
-	d->m_entityCounterLabel->setText( MainWindow::tr( "Entities Count: %1" )
-		.arg( d->m_entityCounter ) );
+void
+MainWindow::leafsBudgetChanged( int count )
+{
+	d->m_context.m_leafBudget->setLimit( count );
+}
 
-	calcMark();
+void
+MainWindow::branchesBudgetChanged( int count )
+{
+	d->m_context.m_branchBudget->setLimit( count );
+}
 
-	d->m_avgFpsLabel->setText( MainWindow::tr( "Avg. FPS: %1" )
-		.arg( QString::number( d->m_totalFps / d->m_secondsCounter, 'f', 2 ) ) );
+void
+MainWindow::targetFpsChanged( int fps )
+{
+	d->m_governor.setTargetFps( fps );
 }
 
 void
-MainWindow::frameProcessed( float )
+MainWindow::frameProcessed( float dt )
 {
 	++d->m_fps;
+
+	// Wind is animated in the vertex shader, the only thing updated per
+	// frame is its time.
+	if( d->m_wind->isChecked() )
+	{
+		d->m_windTime += dt;
+		d->m_effect->setTime( d->m_windTime );
+	}
+
+	if( d->m_adaptiveQuality->isChecked() &&
+		d->m_governor.addFrame( dt * 1000.0f ) )
+			d->applyQuality();
+
+	if( !d->m_playing )
+		return;
+
+	const int steps = d->m_clock.advance( dt * 1000.0f );
+
+	for( int i = 0; i < steps && d->m_playing; ++i )
+		d->simulationStep();
+
+	const float age = ( d->m_interpolate->isChecked() ? d->m_prevAge +
+		( d->m_currentAge - d->m_prevAge ) * d->m_clock.alpha() :
+		d->m_currentAge );
+
+	if( d->m_playing && d->m_interpolate->isChecked() )
+		d->m_forest.interpolate( age );
+
+	// Growth between years and seasons of leafs are one uniform update.
+	if( d->m_context.m_gpuGrowth || d->m_context.m_gpuSeasons )
+		d->m_effect->setAge( age );
 }
 
 void
@@ -447,12 +1051,40 @@ MainWindow::second()
 {
 	d->m_fpsLabel->setText( MainWindow::tr( "FPS: %1" ).arg( d->m_fps ) );
 
+	d->m_visibleTreesLabel->setText( MainWindow::tr( "Visible Trees: %1" )
+		.arg( d->m_forest.visibleTreesCount() ) );
+
 	d->m_totalEntitiesCount += d->m_entityCounter;
 	d->m_totalFps += d->m_fps;
 
 	d->m_fps = 0;
 
 	d->m_secondsCounter += 1.0f;
+
+	if( d->m_context.m_changeCounter )
+	{
+		int ticks = 0;
+
+		const auto changes = d->m_changeCounter.snapshot( &ticks );
+
+		QStringList lines;
+
+		for( int i = 0; i < changes.size() && i < 5; ++i )
+		{
+			QString line = QStringLiteral( "%1: %2" ).arg( changes.at( i ).m_name,
+				QString::number( (double) changes.at( i ).m_recent /
+					(double) qMax( 1, ticks ), 'f', 1 ) );
+
+			// Counted on top of translation, rotation and scale.
+			if( changes.at( i ).m_derived )
+				line += MainWindow::tr( " (derived)" );
+
+			lines.append( line );
+		}
+
+		d->m_changesLabel->setText( MainWindow::tr( "Changes per Tick:\n%1" )
+			.arg( lines.join( QLatin1Char( '\n' ) ) ) );
+	}
 }
 
 void
@@ -463,3 +1095,83 @@ MainWindow::calcMark()
 	d->m_markLabel->setText( MainWindow::tr( "Avg. (FPS / Ent.C.) * Cur.Ent.C.: %1" )
 		.arg( QString::number( mark, 'f', 2 ) ) );
 }
+
+void
+MainWindow::loadPolicyClicked()
+{
+	const QString fileName = QFileDialog::getOpenFileName( this,
+		tr( "Load Growth Policy" ), QString(), tr( "JSON (*.json)" ) );
+
+	if( fileName.isEmpty() )
+		return;
+
+	GrowthPolicy policy;
+	QString error;
+
+	if( !GrowthPolicy::load( fileName, policy, &error ) )
+	{
+		QMessageBox::warning( this, tr( "Unable to load growth policy" ),
+			error );
+
+		return;
+	}
+
+	d->m_species->addItem( policy.name() );
+	d->m_policies.append( policy );
+	d->m_species->setCurrentIndex( d->m_species->count() - 1 );
+}
+
+void
+MainWindow::exportBenchmarkClicked()
+{
+	const QString fileName = QFileDialog::getSaveFileName( this,
+		tr( "Export Benchmark" ), QString(), tr( "JSON (*.json)" ) );
+
+	if( fileName.isEmpty() )
+		return;
+
+	QJsonObject o;
+	o.insert( QStringLiteral( "seconds" ), d->m_secondsCounter );
+	o.insert( QStringLiteral( "avgFps" ), d->m_secondsCounter > 0.0 ?
+		d->m_totalFps / d->m_secondsCounter : 0.0 );
+	o.insert( QStringLiteral( "avgEntities" ), d->m_secondsCounter > 0.0 ?
+		d->m_totalEntitiesCount / d->m_secondsCounter : 0.0 );
+	o.insert( QStringLiteral( "entities" ), (qint64) d->m_entityCounter );
+	o.insert( QStringLiteral( "trees" ), d->m_forest.trees().size() );
+	o.insert( QStringLiteral( "age" ), d->m_currentAge );
+
+	if( d->m_context.m_changeCounter )
+		o.insert( QStringLiteral( "changes" ), d->m_changeCounter.toJson() );
+
+	QFile file( fileName );
+
+	if( !file.open( QIODevice::WriteOnly ) )
+	{
+		QMessageBox::warning( this, tr( "Unable to export benchmark" ),
+			tr( "Unable to open %1." ).arg( fileName ) );
+
+		return;
+	}
+
+	file.write( QJsonDocument( o ).toJson() );
+}
+
+void
+MainWindow::exportTreesClicked()
+{
+	const QString fileName = QFileDialog::getSaveFileName( this,
+		tr( "Export Trees" ), QString(),
+		tr( "glTF (*.gltf);;Wavefront OBJ (*.obj)" ) );
+
+	if( fileName.isEmpty() )
+		return;
+
+	TreeExporter exporter( TreeExporter::formatOf( fileName ) );
+	exporter.setSlices( d->m_context.m_quality.m_slices );
+	exporter.setMergeBranches( d->m_mergeExportedBranches->isChecked() );
+
+	QString error;
+
+	if( !exporter.exportTrees( d->m_forest.trees(), fileName, &error ) )
+		QMessageBox::warning( this, tr( "Unable to export trees" ), error );
+}
@@ -54,14 +54,32 @@ public:
 private slots:
 	//! Play/pause button clicked.
 	void buttonClicked();
-	//! Timer.
-	void timer();
+	//! Simulation step changed.
+	void simulationStepChanged( int ms );
+	//! Adaptive quality toggled.
+	void adaptiveQualityToggled( bool on );
+	//! Target FPS changed.
+	void targetFpsChanged( int fps );
 	//! Frame processed.
 	void frameProcessed( float );
 	//! Second timer.
 	void second();
 	//! Calculate mark.
 	void calcMark();
+	//! Load policy button clicked.
+	void loadPolicyClicked();
+	//! Continuous rendering toggled.
+	void continuousRenderingToggled( bool on );
+	//! Leafs budget changed.
+	void leafsBudgetChanged( int count );
+	//! Branches budget changed.
+	void branchesBudgetChanged( int count );
+	//! Wind toggled.
+	void windToggled( bool on );
+	//! Export benchmark button clicked.
+	void exportBenchmarkClicked();
+	//! Export trees button clicked.
+	void exportTreesClicked();
 
 private:
 	friend class MainWindowPrivate;
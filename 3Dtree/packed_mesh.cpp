@@ -0,0 +1,92 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "packed_mesh.hpp"
+
+// Qt include.
+#include <Qt3DCore/QGeometry>
+#include <Qt3DCore/QBuffer>
+#include <Qt3DCore/QAttribute>
+
+
+//! Count of floats per vertex: position and normal.
+static const int c_vertexSize = 6;
+
+
+//
+// PackedMesh
+//
+
+PackedMesh::PackedMesh( const PackedMeshData & data, Qt3DCore::QNode * parent )
+	:	Qt3DRender::QGeometryRenderer( parent )
+{
+	auto * geometry = new Qt3DCore::QGeometry( this );
+
+	auto * vertexBuffer = new Qt3DCore::QBuffer( geometry );
+	vertexBuffer->setData( QByteArray::fromRawData(
+		reinterpret_cast< const char* > ( data.m_vertices ),
+		data.m_verticesCount * c_vertexSize * sizeof( float ) ) );
+
+	auto * indexBuffer = new Qt3DCore::QBuffer( geometry );
+	indexBuffer->setData( QByteArray::fromRawData(
+		reinterpret_cast< const char* > ( data.m_indices ),
+		data.m_indicesCount * sizeof( quint32 ) ) );
+
+	auto * position = new Qt3DCore::QAttribute( geometry );
+	position->setName( Qt3DCore::QAttribute::defaultPositionAttributeName() );
+	position->setVertexBaseType( Qt3DCore::QAttribute::Float );
+	position->setVertexSize( 3 );
+	position->setAttributeType( Qt3DCore::QAttribute::VertexAttribute );
+	position->setBuffer( vertexBuffer );
+	position->setByteStride( c_vertexSize * sizeof( float ) );
+	position->setByteOffset( 0 );
+	position->setCount( data.m_verticesCount );
+
+	auto * normal = new Qt3DCore::QAttribute( geometry );
+	normal->setName( Qt3DCore::QAttribute::defaultNormalAttributeName() );
+	normal->setVertexBaseType( Qt3DCore::QAttribute::Float );
+	normal->setVertexSize( 3 );
+	normal->setAttributeType( Qt3DCore::QAttribute::VertexAttribute );
+	normal->setBuffer( vertexBuffer );
+	normal->setByteStride( c_vertexSize * sizeof( float ) );
+	normal->setByteOffset( 3 * sizeof( float ) );
+	normal->setCount( data.m_verticesCount );
+
+	auto * index = new Qt3DCore::QAttribute( geometry );
+	index->setVertexBaseType( Qt3DCore::QAttribute::UnsignedInt );
+	index->setAttributeType( Qt3DCore::QAttribute::IndexAttribute );
+	index->setBuffer( indexBuffer );
+	index->setCount( data.m_indicesCount );
+
+	geometry->addAttribute( position );
+	geometry->addAttribute( normal );
+	geometry->addAttribute( index );
+
+	setGeometry( geometry );
+	setPrimitiveType( Qt3DRender::QGeometryRenderer::Triangles );
+	setVertexCount( data.m_indicesCount );
+}
+
+PackedMesh::~PackedMesh()
+{
+}
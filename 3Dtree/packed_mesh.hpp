@@ -0,0 +1,69 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__PACKED_MESH_HPP__INCLUDED
+#define TREE__PACKED_MESH_HPP__INCLUDED
+
+// Qt include.
+#include <Qt3DRender/QGeometryRenderer>
+
+
+//
+// PackedMeshData
+//
+
+//! Mesh packed at build time by mesh_packer. Vertices are interleaved
+//! position and normal.
+struct PackedMeshData Q_DECL_FINAL {
+	//! Vertices.
+	const float * m_vertices;
+	//! Count of vertices.
+	quint32 m_verticesCount;
+	//! Indices of triangles.
+	const quint32 * m_indices;
+	//! Count of indices.
+	quint32 m_indicesCount;
+}; // struct PackedMeshData
+
+//! Leaf mesh, generated from res/leaf.obj.
+extern const PackedMeshData c_leafMeshData;
+
+
+//
+// PackedMesh
+//
+
+//! Geometry renderer of the packed mesh. Buffers reference packed data
+//! directly, nothing is parsed or copied.
+class PackedMesh Q_DECL_FINAL
+	:	public Qt3DRender::QGeometryRenderer
+{
+public:
+	explicit PackedMesh( const PackedMeshData & data,
+		Qt3DCore::QNode * parent = Q_NULLPTR );
+	~PackedMesh();
+
+private:
+	Q_DISABLE_COPY( PackedMesh )
+}; // class PackedMesh
+
+#endif // TREE__PACKED_MESH_HPP__INCLUDED
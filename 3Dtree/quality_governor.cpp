@@ -0,0 +1,189 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "quality_governor.hpp"
+#include "constants.hpp"
+
+// Qt include.
+#include <QObject>
+
+
+//! Duration of the measurement window in milliseconds.
+static const float c_windowDuration = 1000.0f;
+//! Frame time above budget * c_degradeThreshold lowers quality.
+static const float c_degradeThreshold = 1.1f;
+//! Frame time below budget * c_upgradeThreshold raises quality.
+static const float c_upgradeThreshold = 0.6f;
+//! Count of windows to wait after a change.
+static const int c_cooldownWindows = 2;
+
+//! Leafs count isn't limited, policy decides.
+static const quint8 c_allLeafs = 255;
+
+//! Quality levels, from the full to the lowest.
+static const Quality c_levels[] = {
+	{ 20, 10, c_allLeafs, 1, 1 },
+	{ 20, 10, c_allLeafs, 1, 2 },
+	{ 20, 10, c_allLeafs, 2, 2 },
+	{ 4, 8, c_allLeafs, 2, 2 },
+	{ 4, 8, 1, 2, 4 },
+	{ 1, 6, 1, 4, 4 }
+};
+
+//! Count of quality levels.
+static const int c_levelsCount = sizeof( c_levels ) / sizeof( Quality );
+
+
+//
+// Quality
+//
+
+bool
+Quality::operator == ( const Quality & other ) const
+{
+	return ( m_rings == other.m_rings && m_slices == other.m_slices &&
+		m_leafsCount == other.m_leafsCount &&
+		m_animationMultiplier == other.m_animationMultiplier &&
+		m_simulationMultiplier == other.m_simulationMultiplier );
+}
+
+bool
+Quality::operator != ( const Quality & other ) const
+{
+	return !( *this == other );
+}
+
+Quality
+Quality::full()
+{
+	return c_levels[ 0 ];
+}
+
+
+//
+// QualityGovernor
+//
+
+QualityGovernor::QualityGovernor( int targetFps )
+	:	m_budget( 1000.0f / (float) qMax( 1, targetFps ) )
+	,	m_level( 0 )
+	,	m_windowTime( 0.0f )
+	,	m_windowFrames( 0 )
+	,	m_cooldown( 0 )
+{
+}
+
+int
+QualityGovernor::targetFps() const
+{
+	return qRound( 1000.0f / m_budget );
+}
+
+void
+QualityGovernor::setTargetFps( int fps )
+{
+	m_budget = 1000.0f / (float) qMax( 1, fps );
+}
+
+void
+QualityGovernor::reset()
+{
+	m_level = 0;
+	m_windowTime = 0.0f;
+	m_windowFrames = 0;
+	m_cooldown = 0;
+}
+
+bool
+QualityGovernor::addFrame( float ms )
+{
+	m_windowTime += ms;
+	++m_windowFrames;
+
+	if( m_windowTime < c_windowDuration )
+		return false;
+
+	const float avg = m_windowTime / (float) m_windowFrames;
+
+	m_windowTime = 0.0f;
+	m_windowFrames = 0;
+
+	if( m_cooldown > 0 )
+	{
+		--m_cooldown;
+
+		return false;
+	}
+
+	if( avg > m_budget * c_degradeThreshold && m_level < c_levelsCount - 1 )
+	{
+		++m_level;
+		m_cooldown = c_cooldownWindows;
+
+		return true;
+	}
+	else if( avg < m_budget * c_upgradeThreshold && m_level > 0 )
+	{
+		--m_level;
+		m_cooldown = c_cooldownWindows;
+
+		return true;
+	}
+
+	return false;
+}
+
+const Quality &
+QualityGovernor::quality() const
+{
+	return c_levels[ m_level ];
+}
+
+int
+QualityGovernor::level() const
+{
+	return m_level;
+}
+
+QStringList
+QualityGovernor::reducedKnobs() const
+{
+	const Quality & f = c_levels[ 0 ];
+	const Quality & c = quality();
+
+	QStringList res;
+
+	if( c.m_rings != f.m_rings || c.m_slices != f.m_slices )
+		res.append( QObject::tr( "branch tessellation" ) );
+
+	if( c.m_leafsCount != f.m_leafsCount )
+		res.append( QObject::tr( "leafs density" ) );
+
+	if( c.m_animationMultiplier != f.m_animationMultiplier )
+		res.append( QObject::tr( "leafs fall rate" ) );
+
+	if( c.m_simulationMultiplier != f.m_simulationMultiplier )
+		res.append( QObject::tr( "simulation rate" ) );
+
+	return res;
+}
@@ -0,0 +1,99 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__QUALITY_GOVERNOR_HPP__INCLUDED
+#define TREE__QUALITY_GOVERNOR_HPP__INCLUDED
+
+// Qt include.
+#include <QtGlobal>
+#include <QStringList>
+
+
+//
+// Quality
+//
+
+//! Quality knobs.
+struct Quality Q_DECL_FINAL {
+	//! Rings of the branch cone.
+	int m_rings;
+	//! Slices of the branch cone.
+	int m_slices;
+	//! Max count of leafs on the new branch.
+	quint8 m_leafsCount;
+	//! Multiplier of the leafs animation interval.
+	int m_animationMultiplier;
+	//! Multiplier of the simulation step.
+	int m_simulationMultiplier;
+
+	bool operator == ( const Quality & other ) const;
+	bool operator != ( const Quality & other ) const;
+
+	//! \return Full quality.
+	static Quality full();
+}; // struct Quality
+
+
+//
+// QualityGovernor
+//
+
+//! Watches frame time and scales quality knobs to hold target frame rate.
+class QualityGovernor Q_DECL_FINAL {
+public:
+	explicit QualityGovernor( int targetFps );
+
+	//! \return Target FPS.
+	int targetFps() const;
+	//! Set target FPS.
+	void setTargetFps( int fps );
+
+	//! Reset to the full quality.
+	void reset();
+
+	//! Add measured frame time in milliseconds.
+	//! \return true if quality was changed.
+	bool addFrame( float ms );
+
+	//! \return Current quality.
+	const Quality & quality() const;
+
+	//! \return Current level, 0 is the full quality.
+	int level() const;
+
+	//! \return Names of knobs turned down.
+	QStringList reducedKnobs() const;
+
+private:
+	//! Target frame time in milliseconds.
+	float m_budget;
+	//! Level.
+	int m_level;
+	//! Accumulated frame time in the window.
+	float m_windowTime;
+	//! Count of frames in the window.
+	int m_windowFrames;
+	//! Count of windows to wait before next change.
+	int m_cooldown;
+}; // class QualityGovernor
+
+#endif // TREE__QUALITY_GOVERNOR_HPP__INCLUDED
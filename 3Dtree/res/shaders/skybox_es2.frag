@@ -0,0 +1,12 @@
+#ifdef GL_ES
+precision highp float;
+#endif
+
+varying vec3 texCoord;
+
+uniform samplerCube skyboxTexture;
+
+void main()
+{
+    gl_FragColor = textureCube( skyboxTexture, texCoord );
+}
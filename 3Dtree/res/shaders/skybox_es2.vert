@@ -0,0 +1,19 @@
+attribute vec3 vertexPosition;
+
+varying vec3 texCoord;
+
+uniform mat4 modelMatrix;
+uniform mat4 viewMatrix;
+uniform mat4 projectionMatrix;
+
+void main()
+{
+    texCoord = vertexPosition;
+
+    // Sky box follows the camera, it's drawn on the far plane.
+    mat4 rotation = viewMatrix;
+    rotation[ 3 ] = vec4( 0.0, 0.0, 0.0, 1.0 );
+
+    gl_Position = ( projectionMatrix * rotation *
+        modelMatrix * vec4( vertexPosition, 1.0 ) ).xyww;
+}
@@ -0,0 +1,149 @@
+#version 150 core
+
+in vec3 vertexPosition;
+in vec3 vertexNormal;
+
+out vec3 worldPosition;
+out vec3 worldNormal;
+out vec3 diffuseColor;
+
+uniform mat4 modelMatrix;
+uniform mat3 modelNormalMatrix;
+uniform mat4 viewProjectionMatrix;
+
+uniform float windTime;
+uniform vec3 windDirection;
+uniform float windStrength;
+uniform float flutter;
+
+uniform float treeAge;
+uniform float branchScale;
+uniform float branchLengthMultiplicator;
+uniform float branchSlower;
+uniform float firstBranchGrowsFaster;
+
+uniform float birthAge;
+uniform float branchLength;
+uniform float growthRole;
+uniform vec3 springOffset;
+
+uniform vec4 kd;
+uniform float turnAge;
+uniform float autumnIndex;
+uniform float fallAge;
+
+// Fall of the leaf as in Leaf::timeout() with default speed, per year.
+const float fallSpeed = 30.0;
+const float fallSpin = 157.0;
+
+// Same curves as in BranchPrivate::grow().
+float summerAge( float age )
+{
+    float year = floor( age );
+
+    return year + min( ( age - year ) * 4.0, 1.0 );
+}
+
+float growthScale( float s )
+{
+    return ( s <= 1.0 ? s : 1.0 + s / ( 100.0 / branchScale ) );
+}
+
+float growthLength( float s )
+{
+    return branchLength + branchLength * s /
+        ( 100.0 / branchLengthMultiplicator ) /
+        ( growthRole > 1.5 ? 1.0 : branchSlower ) *
+        ( growthRole > 2.5 ? firstBranchGrowsFaster : 1.0 );
+}
+
+// Bend grows with the square of the height, so the trunk stands still and
+// thin branches of the crown, being higher in the hierarchy, sway the most.
+// Phase depends on the position on the ground, so trees don't move in sync.
+vec3 sway( vec3 p )
+{
+    float phase = dot( p.xz, vec2( 0.37, 0.23 ) );
+    float gust = sin( windTime * 1.3 + phase ) +
+        0.3 * sin( windTime * 3.7 + phase * 1.7 );
+    float h = max( p.y, 0.0 );
+
+    return windDirection * ( windStrength * 0.005 * h * h * gust );
+}
+
+void main()
+{
+    vec3 position = vertexPosition;
+    vec3 normal = vertexNormal;
+    vec3 offset = springOffset * ( 1.0 - min( fract( treeAge ) * 4.0, 1.0 ) );
+    float fall = 0.0;
+
+    diffuseColor = kd.rgb;
+
+    if( growthRole > 3.5 )
+    {
+        // Leaf grows in the spring, turns color and falls in the autumn.
+        float season = treeAge - birthAge;
+
+        position *= clamp( season * 4.0, 0.0, 1.0 );
+
+        if( season >= turnAge )
+            diffuseColor = mix( vec3( 1.0, 1.0, 0.0 ), vec3( 1.0, 0.0, 0.0 ),
+                ( autumnIndex + 0.5 ) / 100.0 );
+
+        if( season >= fallAge )
+        {
+            fall = season - fallAge;
+            offset = vec3( 0.0 );
+        }
+    }
+    else if( growthRole > 0.5 )
+    {
+        // Transform has the state at the end of the spring of this year,
+        // scale the unit cone from its bottom to the current state.
+        float age = max( treeAge - birthAge, 0.0 );
+        float s = summerAge( age );
+        float e = floor( age ) + 1.0;
+        float radial = max( growthScale( s ) / growthScale( e ), 0.0001 );
+        float axial = max( radial * growthLength( s ) / growthLength( e ),
+            0.0001 );
+
+        position = vec3( position.x * radial,
+            ( position.y + 0.5 ) * axial - 0.5, position.z * radial );
+        normal = vec3( normal.x / radial, normal.y / axial, normal.z / radial );
+    }
+
+    // Bottom of the branch follows the top of the parent during the spring.
+    vec3 pos = ( modelMatrix * vec4( position, 1.0 ) ).xyz + offset;
+    vec3 n = modelNormalMatrix * normal;
+
+    if( fall > 0.0 )
+    {
+        // Falling leaf spins around the vertical axis and hides in the ground.
+        vec3 origin = ( modelMatrix * vec4( 0.0, 0.0, 0.0, 1.0 ) ).xyz;
+        float c = cos( fall * fallSpin );
+        float s = sin( fall * fallSpin );
+        vec3 r = pos - origin;
+
+        origin.y -= fall * fallSpeed;
+
+        pos = origin + ( origin.y > 0.0 ?
+            vec3( c * r.x + s * r.z, r.y, c * r.z - s * r.x ) : vec3( 0.0 ) );
+        n = vec3( c * n.x + s * n.z, n.y, c * n.z - s * n.x );
+    }
+    else if( flutter > 0.0 )
+    {
+        // Leaf follows the end of its branch and flutters around the stalk.
+        vec3 origin = ( modelMatrix * vec4( 0.0, 0.0, 0.0, 1.0 ) ).xyz + offset;
+        float phase = dot( origin, vec3( 12.9898, 78.233, 37.719 ) );
+
+        pos += sway( origin ) + windDirection * ( flutter * windStrength *
+            length( pos - origin ) * sin( windTime * 9.0 + phase ) );
+    }
+    else
+        pos += sway( pos );
+
+    worldPosition = pos;
+    worldNormal = normalize( n );
+
+    gl_Position = viewProjectionMatrix * vec4( pos, 1.0 );
+}
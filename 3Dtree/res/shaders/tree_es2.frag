@@ -0,0 +1,32 @@
+#ifdef GL_ES
+precision highp float;
+#endif
+
+varying vec3 worldPosition;
+varying vec3 worldNormal;
+varying vec3 diffuseColor;
+
+uniform vec3 eyePosition;
+uniform vec3 lightPosition;
+uniform float lightIntensity;
+
+uniform vec4 ka;
+uniform vec4 ks;
+uniform float shininess;
+
+void main()
+{
+    // Leafs are flat, so back side is lit as the front one.
+    vec3 n = normalize( gl_FrontFacing ? worldNormal : -worldNormal );
+    vec3 l = normalize( lightPosition - worldPosition );
+    vec3 v = normalize( eyePosition - worldPosition );
+
+    float diffuse = max( dot( n, l ), 0.0 );
+    float specular = 0.0;
+
+    if( diffuse > 0.0 )
+        specular = pow( max( dot( reflect( -l, n ), v ), 0.0 ), shininess );
+
+    gl_FragColor = vec4( ka.rgb + lightIntensity *
+        ( diffuseColor * diffuse + ks.rgb * specular ), 1.0 );
+}
@@ -0,0 +1,97 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "simulation_clock.hpp"
+
+
+//
+// SimulationClock
+//
+
+SimulationClock::SimulationClock( int step, int maxStepsPerFrame )
+	:	m_step( qMax( 1, step ) )
+	,	m_maxSteps( qMax( 1, maxStepsPerFrame ) )
+	,	m_accumulator( 0.0f )
+{
+}
+
+int
+SimulationClock::step() const
+{
+	return m_step;
+}
+
+void
+SimulationClock::setStep( int ms )
+{
+	m_step = qMax( 1, ms );
+
+	if( m_accumulator > (float) m_step )
+		m_accumulator = (float) m_step;
+}
+
+int
+SimulationClock::maxStepsPerFrame() const
+{
+	return m_maxSteps;
+}
+
+void
+SimulationClock::setMaxStepsPerFrame( int count )
+{
+	m_maxSteps = qMax( 1, count );
+}
+
+void
+SimulationClock::reset()
+{
+	m_accumulator = 0.0f;
+}
+
+int
+SimulationClock::advance( float elapsed )
+{
+	if( elapsed > 0.0f )
+		m_accumulator += elapsed;
+
+	int steps = 0;
+
+	while( m_accumulator >= (float) m_step && steps < m_maxSteps )
+	{
+		m_accumulator -= (float) m_step;
+
+		++steps;
+	}
+
+	// Drop backlog.
+	if( m_accumulator >= (float) m_step )
+		m_accumulator = 0.0f;
+
+	return steps;
+}
+
+float
+SimulationClock::alpha() const
+{
+	return qBound( 0.0f, m_accumulator / (float) m_step, 1.0f );
+}
@@ -0,0 +1,70 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__SIMULATION_CLOCK_HPP__INCLUDED
+#define TREE__SIMULATION_CLOCK_HPP__INCLUDED
+
+// Qt include.
+#include <QtGlobal>
+
+
+//
+// SimulationClock
+//
+
+//! Fixed-timestep simulation clock, independent of the frame rate.
+class SimulationClock Q_DECL_FINAL {
+public:
+	SimulationClock( int step, int maxStepsPerFrame );
+
+	//! \return Simulation step in milliseconds.
+	int step() const;
+	//! Set simulation step in milliseconds.
+	void setStep( int ms );
+
+	//! \return Maximum count of steps processed per one frame.
+	int maxStepsPerFrame() const;
+	//! Set maximum count of steps processed per one frame.
+	void setMaxStepsPerFrame( int count );
+
+	//! Reset accumulated time.
+	void reset();
+
+	//! Advance clock on \a elapsed milliseconds.
+	//! \return Count of simulation steps to run. Backlog that doesn't fit
+	//! into maxStepsPerFrame() is dropped, so slow frames don't stall UI.
+	int advance( float elapsed );
+
+	//! \return Interpolation factor in range [0.0, 1.0] between previous
+	//! and current simulation states.
+	float alpha() const;
+
+private:
+	//! Step.
+	int m_step;
+	//! Maximum steps per frame.
+	int m_maxSteps;
+	//! Accumulated time.
+	float m_accumulator;
+}; // class SimulationClock
+
+#endif // TREE__SIMULATION_CLOCK_HPP__INCLUDED
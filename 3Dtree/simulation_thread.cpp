@@ -0,0 +1,162 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "simulation_thread.hpp"
+
+// Qt include.
+#include <QMutexLocker>
+
+
+//
+// GrowthSimulation
+//
+
+GrowthSimulation::GrowthSimulation( std::unique_ptr< GrowthEngine > engine )
+	:	m_engine( std::move( engine ) )
+	,	m_target( 0 )
+	,	m_generation( 0 )
+	,	m_busy( false )
+{
+}
+
+void
+GrowthSimulation::request( int generation )
+{
+	m_target.store( generation, std::memory_order_release );
+}
+
+bool
+GrowthSimulation::update()
+{
+	return m_snapshots.update();
+}
+
+const GrowthSnapshot &
+GrowthSimulation::snapshot() const
+{
+	return m_snapshots.readBuffer();
+}
+
+void
+GrowthSimulation::simulate()
+{
+	const int target = m_target.load( std::memory_order_acquire );
+
+	if( target <= m_generation )
+		return;
+
+	m_engine->grow( target );
+	m_generation = target;
+
+	GrowthSnapshot & s = m_snapshots.writeBuffer();
+	s.m_generation = target;
+	s.m_nodes = m_engine->nodes();
+
+	m_snapshots.publish();
+}
+
+
+//
+// SimulationThread
+//
+
+SimulationThread::SimulationThread()
+	:	m_stop( false )
+{
+}
+
+SimulationThread::~SimulationThread()
+{
+	m_stop = true;
+	m_wake.release();
+
+	wait();
+}
+
+void
+SimulationThread::add( GrowthSimulation * s )
+{
+	QMutexLocker lock( &m_mutex );
+
+	m_simulations.append( s );
+}
+
+void
+SimulationThread::remove( GrowthSimulation * s )
+{
+	QMutexLocker lock( &m_mutex );
+
+	m_simulations.removeOne( s );
+
+	while( s->m_busy )
+		m_done.wait( &m_mutex );
+}
+
+void
+SimulationThread::wake()
+{
+	m_wake.release();
+}
+
+void
+SimulationThread::run()
+{
+	while( true )
+	{
+		m_wake.acquire();
+
+		// Requests are picked up by one pass.
+		m_wake.tryAcquire( m_wake.available() );
+
+		if( m_stop )
+			break;
+
+		// Lock is held only to pick the next simulation, so adding and
+		// removing of other trees don't wait for the pass. Simulation
+		// removed in the pass may shift the next one to the next pass.
+		for( int i = 0; !m_stop; ++i )
+		{
+			GrowthSimulation * s = Q_NULLPTR;
+
+			{
+				QMutexLocker lock( &m_mutex );
+
+				if( i >= m_simulations.size() )
+					break;
+
+				s = m_simulations.at( i );
+				s->m_busy = true;
+			}
+
+			s->simulate();
+
+			{
+				QMutexLocker lock( &m_mutex );
+
+				s->m_busy = false;
+
+				m_done.wakeAll();
+			}
+		}
+	}
+}
@@ -0,0 +1,146 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__SIMULATION_THREAD_HPP__INCLUDED
+#define TREE__SIMULATION_THREAD_HPP__INCLUDED
+
+// 3Dtree include.
+#include "growth_engine.hpp"
+#include "triple_buffer.hpp"
+
+// Qt include.
+#include <QThread>
+#include <QMutex>
+#include <QSemaphore>
+#include <QWaitCondition>
+#include <QVector>
+
+// C++ include.
+#include <atomic>
+#include <memory>
+#include <vector>
+
+
+//
+// GrowthSnapshot
+//
+
+//! Nodes of the growth engine published for rendering.
+struct GrowthSnapshot Q_DECL_FINAL {
+	GrowthSnapshot()
+		:	m_generation( 0 )
+	{
+	}
+
+	//! Generation.
+	int m_generation;
+	//! Nodes.
+	std::vector< GrowthNode > m_nodes;
+}; // struct GrowthSnapshot
+
+
+//
+// GrowthSimulation
+//
+
+//! Growth engine of one tree. The GUI thread requests generations and
+//! picks up snapshots, the simulation thread grows the engine and
+//! publishes snapshots through the triple buffer.
+class GrowthSimulation Q_DECL_FINAL {
+public:
+	explicit GrowthSimulation( std::unique_ptr< GrowthEngine > engine );
+
+	//! Request growth to the given generation. GUI thread.
+	void request( int generation );
+
+	//! Pick up the latest snapshot. GUI thread.
+	//! \return false if there is no new snapshot.
+	bool update();
+
+	//! \return Snapshot picked up by update(). GUI thread.
+	const GrowthSnapshot & snapshot() const;
+
+	//! Grow the engine to the requested generation and publish the
+	//! snapshot. Simulation thread, or GUI thread without one.
+	void simulate();
+
+private:
+	friend class SimulationThread;
+
+	//! Engine.
+	std::unique_ptr< GrowthEngine > m_engine;
+	//! Requested generation.
+	std::atomic< int > m_target;
+	//! Generation of the engine.
+	int m_generation;
+	//! Snapshots.
+	TripleBuffer< GrowthSnapshot > m_snapshots;
+	//! Is it being simulated by the thread? Guarded by the thread.
+	bool m_busy;
+
+	Q_DISABLE_COPY( GrowthSimulation )
+}; // class GrowthSimulation
+
+
+//
+// SimulationThread
+//
+
+//! Thread growing engines of all trees, shared by trees. Slow generations
+//! don't block input and rendering, trees show the previous generation
+//! till the new one is published.
+class SimulationThread Q_DECL_FINAL
+	:	public QThread
+{
+public:
+	SimulationThread();
+	~SimulationThread();
+
+	//! Add simulation.
+	void add( GrowthSimulation * s );
+
+	//! Remove simulation, waits only if this simulation is being simulated.
+	void remove( GrowthSimulation * s );
+
+	//! Wake the thread up to simulate requested generations.
+	void wake();
+
+protected:
+	void run() Q_DECL_OVERRIDE;
+
+private:
+	//! Guards the list of simulations and their busy flags. Isn't held
+	//! while simulating.
+	QMutex m_mutex;
+	//! Simulation is done.
+	QWaitCondition m_done;
+	//! Simulations.
+	QVector< GrowthSimulation* > m_simulations;
+	//! Wake ups.
+	QSemaphore m_wake;
+	//! Stop the thread?
+	std::atomic< bool > m_stop;
+
+	Q_DISABLE_COPY( SimulationThread )
+}; // class SimulationThread
+
+#endif // TREE__SIMULATION_THREAD_HPP__INCLUDED
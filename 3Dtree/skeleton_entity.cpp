@@ -0,0 +1,586 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "skeleton_entity.hpp"
+#include "tree_context.hpp"
+#include "cone_cache.hpp"
+#include "change_counter.hpp"
+#include "tree_material.hpp"
+#include "leaf.hpp"
+#include "branch_budget.hpp"
+
+// Qt include.
+#include <Qt3DCore/QTransform>
+#include <Qt3DExtras/QConeMesh>
+#include <Qt3DRender/QGeometryRenderer>
+
+#include <QList>
+#include <QPointer>
+
+// C++ include.
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+
+//! Difference of radii ratio the mesh of the part is changed on.
+static const float c_ratioThreshold = 0.01f;
+
+
+//
+// SkeletonPart
+//
+
+//! Rendered node.
+struct SkeletonPart Q_DECL_FINAL {
+	//! Entity.
+	Qt3DCore::QEntity * m_entity;
+	//! Transform.
+	Qt3DCore::QTransform * m_transform;
+	//! Shared mesh with the unit bottom radius.
+	Qt3DExtras::QConeMesh * m_mesh;
+	//! Ratio of the top radius to the bottom one.
+	float m_ratio;
+	//! Parent part, null for the trunk.
+	SkeletonPart * m_parent;
+	//! Age of the tree when the node starts to grow to the new size.
+	float m_growStart;
+	//! Length before the growth.
+	float m_fromLength;
+	//! Bottom radius before the growth.
+	float m_fromRadius;
+	//! Length.
+	float m_length;
+	//! Bottom radius.
+	float m_radius;
+	//! Direction.
+	QVector3D m_direction;
+	//! Start position, leafs reference it.
+	QVector3D m_startPos;
+	//! End position, leafs reference it.
+	QVector3D m_endPos;
+	//! Is the node grown, so it won't change till the next generation?
+	bool m_settled;
+	//! Is the node a tip?
+	bool m_tip;
+	//! Has the tip leafs of the current year?
+	bool m_hasLeafs;
+}; // struct SkeletonPart
+
+
+//
+// SkeletonLeaf
+//
+
+//! Leaf on the tip.
+struct SkeletonLeaf Q_DECL_FINAL {
+	//! Leaf, it deletes itself after the fall.
+	QPointer< Leaf > m_leaf;
+	//! Part the leaf grows on.
+	SkeletonPart * m_part;
+	//! Age of the tree when the leaf was born.
+	float m_birth;
+	//! Age of the leaf when it turns color.
+	float m_turnAge;
+	//! Age of the leaf when it falls.
+	float m_fallAge;
+	//! Has the leaf turned color?
+	bool m_autumn;
+	//! Is the leaf falling?
+	bool m_fallen;
+}; // struct SkeletonLeaf
+
+
+//! \return Ratio of the top radius to the bottom one.
+static inline float radiiRatio( const GrowthNode & n )
+{
+	return ( n.m_bottomRadius > 0.0f ? n.m_topRadius / n.m_bottomRadius : 1.0f );
+}
+
+
+//
+// SkeletonEntityPrivate
+//
+
+class SkeletonEntityPrivate {
+public:
+	SkeletonEntityPrivate( TreeContext * context, SkeletonEntity * parent )
+		:	m_context( context )
+		,	m_maxBirth( -1.0f )
+		,	m_age( 0.0f )
+		,	q( parent )
+	{
+	}
+
+	~SkeletonEntityPrivate()
+	{
+		deleteLeafs();
+
+		for( const auto & p : m_parts )
+		{
+			if( p )
+				releasePart( *p );
+		}
+	}
+
+	//! \return New part.
+	std::unique_ptr< SkeletonPart > createPart( const GrowthNode & node );
+	//! Release mesh and counters of the part.
+	void releasePart( const SkeletonPart & part );
+	//! Set mesh of the part.
+	void setMesh( SkeletonPart & part, float ratio, int rings, int slices );
+	//! \return Max count of parts of this skeleton allowed by the budget.
+	size_t allowedParts() const;
+	//! Create leafs on the tips without leafs.
+	void createLeafs();
+	//! Delete leafs.
+	void deleteLeafs();
+	//! Delete leafs of previous years and of nodes that aren't tips.
+	void dropOldLeafs();
+	//! Apply growth of the given age to leafs.
+	void updateLeafs( float age );
+
+	//! Tree context.
+	TreeContext * m_context;
+	//! Parts by index of the node, null if the node isn't rendered.
+	std::vector< std::unique_ptr< SkeletonPart > > m_parts;
+	//! Rendered parts, parent is always before its children.
+	std::vector< SkeletonPart* > m_order;
+	//! Max birth of the nodes, nodes born later are new.
+	float m_maxBirth;
+	//! Leafs.
+	QList< SkeletonLeaf > m_leafs;
+	//! Age.
+	float m_age;
+	//! Parent.
+	SkeletonEntity * q;
+}; // class SkeletonEntityPrivate
+
+std::unique_ptr< SkeletonPart >
+SkeletonEntityPrivate::createPart( const GrowthNode & node )
+{
+	std::unique_ptr< SkeletonPart > p( new SkeletonPart {
+		new Qt3DCore::QEntity( q ), Q_NULLPTR, Q_NULLPTR, 0.0f, Q_NULLPTR,
+		node.m_birth, 0.0f, 0.0f, node.m_length, node.m_bottomRadius,
+		node.m_direction, QVector3D(), QVector3D(), false, false, false } );
+
+	auto transform = std::make_unique< Qt3DCore::QTransform > ();
+	transform->setScale( 0.0f );
+
+	p->m_transform = transform.get();
+
+	p->m_entity->addComponent( transform.release() );
+	p->m_entity->addComponent( m_context->m_material );
+
+	setMesh( *p, radiiRatio( node ), m_context->m_quality.m_rings,
+		m_context->m_quality.m_slices );
+
+	++( *m_context->m_entityCounter );
+
+	if( m_context->m_branchBudget )
+		m_context->m_branchBudget->addBranch( Q_NULLPTR );
+
+	if( m_context->m_changeCounter )
+		m_context->m_changeCounter->watch( p->m_entity );
+
+	return p;
+}
+
+void
+SkeletonEntityPrivate::releasePart( const SkeletonPart & part )
+{
+	m_context->m_coneCache->release( part.m_mesh );
+
+	--( *m_context->m_entityCounter );
+
+	if( m_context->m_branchBudget )
+		m_context->m_branchBudget->removeBranch();
+}
+
+void
+SkeletonEntityPrivate::setMesh( SkeletonPart & part, float ratio,
+	int rings, int slices )
+{
+	// Radius is applied by the transform, so all parts with close ratios
+	// share one mesh.
+	auto * mesh = m_context->m_coneCache->acquire( 1.0f, ratio, rings, slices );
+
+	if( part.m_mesh )
+	{
+		part.m_entity->removeComponent( part.m_mesh );
+		m_context->m_coneCache->release( part.m_mesh );
+	}
+
+	part.m_mesh = mesh;
+	part.m_ratio = ratio;
+	part.m_entity->addComponent( mesh );
+
+	if( m_context->m_changeCounter )
+		m_context->m_changeCounter->watch( mesh );
+}
+
+size_t
+SkeletonEntityPrivate::allowedParts() const
+{
+	const auto & budget = m_context->m_branchBudget;
+
+	if( !budget || budget->limit() == 0 )
+		return std::numeric_limits< size_t >::max();
+
+	// Budget is shared with other trees.
+	const int others = budget->count() - (int) m_order.size();
+
+	return (size_t) qMax( 1, budget->limit() - others );
+}
+
+void
+SkeletonEntityPrivate::createLeafs()
+{
+	const auto & policy = m_context->m_policy;
+	auto & gen = m_context->m_generator;
+
+	std::uniform_real_distribution< float > rotdis( 0.0f,
+		policy.leafRotationDistortion() );
+
+	const quint8 count = qMin( policy.leafsCount(),
+		m_context->m_quality.m_leafsCount );
+	const float birth = std::floor( m_age );
+
+	for( const auto & p : m_order )
+	{
+		if( !p->m_tip || p->m_hasLeafs )
+			continue;
+
+		p->m_hasLeafs = true;
+
+		if( m_context->m_useInstanceRendering )
+			m_context->m_leafMesh->setInstanceCount(
+				m_context->m_leafMesh->instanceCount() + count );
+
+		float angle = rotdis( gen );
+
+		for( quint8 k = 0; k < count; ++k )
+		{
+			auto * leaf = new Leaf( p->m_startPos, p->m_endPos, m_context,
+				Q_NULLPTR, ( m_context->m_leafsParent ?
+					m_context->m_leafsParent : q->parentEntity() ) );
+
+			leaf->rotate( angle );
+			leaf->updatePosition();
+			leaf->setAge( 0.0f );
+
+			if( m_context->m_gpuSeasons )
+				leaf->setSeason( birth );
+
+			m_leafs.append( { leaf, p, birth,
+				Leaf::turnAge( 0.0f, m_context ),
+				Leaf::fallAge( 0.0f, m_context ), false, false } );
+
+			angle += 360.0f / (float) count;
+		}
+	}
+}
+
+void
+SkeletonEntityPrivate::deleteLeafs()
+{
+	for( const auto & l : qAsConst( m_leafs ) )
+	{
+		// Falling leaf deletes itself.
+		if( l.m_leaf && !l.m_fallen )
+		{
+			if( m_context->m_useInstanceRendering )
+				m_context->m_leafMesh->setInstanceCount(
+					m_context->m_leafMesh->instanceCount() - 1 );
+
+			delete l.m_leaf.data();
+		}
+	}
+
+	m_leafs.clear();
+}
+
+void
+SkeletonEntityPrivate::dropOldLeafs()
+{
+	const float year = std::floor( m_age );
+
+	for( auto it = m_leafs.begin(); it != m_leafs.end(); )
+	{
+		// Leafs of this year stay on the tips.
+		if( it->m_leaf && !it->m_fallen && it->m_birth == year &&
+			it->m_part && it->m_part->m_tip )
+		{
+			it->m_part->m_hasLeafs = true;
+
+			++it;
+
+			continue;
+		}
+
+		if( it->m_leaf && !it->m_fallen )
+		{
+			if( m_context->m_useInstanceRendering )
+				m_context->m_leafMesh->setInstanceCount(
+					m_context->m_leafMesh->instanceCount() - 1 );
+
+			delete it->m_leaf.data();
+		}
+
+		it = m_leafs.erase( it );
+	}
+}
+
+void
+SkeletonEntityPrivate::updateLeafs( float age )
+{
+	for( auto & l : m_leafs )
+	{
+		if( !l.m_leaf || l.m_fallen )
+			continue;
+
+		const float a = age - l.m_birth;
+
+		// Shader grows, colors and drops the leaf.
+		if( m_context->m_gpuSeasons )
+		{
+			if( a <= 0.5f )
+				l.m_leaf->updatePosition();
+		}
+		else if( a <= 0.5f )
+		{
+			l.m_leaf->setAge( a * 4.0f );
+			l.m_leaf->updatePosition();
+		}
+		else if( a >= l.m_fallAge )
+		{
+			l.m_leaf->fallAndDie();
+			l.m_fallen = true;
+		}
+		else if( a >= l.m_turnAge && !l.m_autumn )
+		{
+			l.m_leaf->setColor( Leaf::autumnColor( m_context->m_generator ) );
+			l.m_autumn = true;
+		}
+	}
+}
+
+
+//
+// SkeletonEntity
+//
+
+SkeletonEntity::SkeletonEntity( TreeContext * context,
+	Qt3DCore::QEntity * parent )
+	:	Qt3DCore::QEntity( parent )
+	,	d( new SkeletonEntityPrivate( context, this ) )
+{
+}
+
+SkeletonEntity::~SkeletonEntity()
+{
+}
+
+void
+SkeletonEntity::setNodes( const std::vector< GrowthNode > & nodes, float age )
+{
+	d->m_age = age;
+
+	// Nodes of the previous generations keep their order, so they are
+	// matched to their parts in one pass. Otherwise all parts are new.
+	size_t old = 0;
+	float maxBirth = -1.0f;
+
+	for( const auto & n : nodes )
+	{
+		if( n.m_birth <= d->m_maxBirth )
+			++old;
+
+		maxBirth = qMax( maxBirth, n.m_birth );
+	}
+
+	std::vector< std::unique_ptr< SkeletonPart > > prev;
+	prev.swap( d->m_parts );
+
+	if( old != prev.size() )
+		old = 0;
+
+	// Older nodes are rendered first when the budget is exceeded, parent
+	// is never younger than its children.
+	std::vector< qint32 > byBirth( nodes.size() );
+
+	for( size_t i = 0; i < nodes.size(); ++i )
+		byBirth[ i ] = (qint32) i;
+
+	std::stable_sort( byBirth.begin(), byBirth.end(),
+		[&nodes] ( qint32 a, qint32 b )
+			{ return nodes[ a ].m_birth < nodes[ b ].m_birth; } );
+
+	const size_t allowed = d->allowedParts();
+	std::vector< bool > rendered( nodes.size(), false );
+	size_t count = 0;
+
+	for( const auto & i : byBirth )
+	{
+		const auto & n = nodes[ i ];
+
+		rendered[ i ] = ( count < allowed && n.m_alive &&
+			( n.m_parent < 0 || rendered[ n.m_parent ] ) );
+
+		if( rendered[ i ] )
+			++count;
+	}
+
+	d->m_parts.resize( nodes.size() );
+
+	for( size_t i = 0, j = 0; i < nodes.size(); ++i )
+	{
+		const auto & n = nodes[ i ];
+
+		if( old && n.m_birth <= d->m_maxBirth )
+		{
+			auto & p = prev[ j++ ];
+
+			if( rendered[ i ] )
+				d->m_parts[ i ] = std::move( p );
+		}
+	}
+
+	// Leafs of removed parts are dropped with other old leafs.
+	for( const auto & p : prev )
+	{
+		if( p )
+			p->m_tip = false;
+	}
+
+	d->m_order.clear();
+	d->m_order.reserve( count );
+
+	for( size_t i = 0; i < nodes.size(); ++i )
+	{
+		const auto & n = nodes[ i ];
+
+		if( !rendered[ i ] )
+			continue;
+
+		auto & p = d->m_parts[ i ];
+
+		if( !p )
+			p = d->createPart( n );
+		else
+		{
+			if( std::abs( radiiRatio( n ) - p->m_ratio ) > c_ratioThreshold )
+				d->setMesh( *p, radiiRatio( n ),
+					d->m_context->m_quality.m_rings,
+					d->m_context->m_quality.m_slices );
+
+			// Old nodes grow to the new size in the spring of this year.
+			if( p->m_length != n.m_length || p->m_radius != n.m_bottomRadius )
+			{
+				p->m_growStart = std::floor( age );
+				p->m_fromLength = p->m_length;
+				p->m_fromRadius = p->m_radius;
+				p->m_length = n.m_length;
+				p->m_radius = n.m_bottomRadius;
+				p->m_settled = false;
+			}
+		}
+
+		p->m_parent = ( n.m_parent < 0 ? Q_NULLPTR :
+			d->m_parts[ n.m_parent ].get() );
+		p->m_tip = true;
+		p->m_hasLeafs = false;
+
+		if( p->m_parent )
+			p->m_parent->m_tip = false;
+
+		d->m_order.push_back( p.get() );
+	}
+
+	d->m_maxBirth = maxBirth;
+
+	d->dropOldLeafs();
+
+	for( const auto & p : prev )
+	{
+		if( p )
+		{
+			d->releasePart( *p );
+
+			delete p->m_entity;
+		}
+	}
+
+	prev.clear();
+
+	setAge( age );
+
+	d->createLeafs();
+}
+
+void
+SkeletonEntity::setAge( float age )
+{
+	d->m_age = age;
+
+	const QVector3D up( 0.0f, 1.0f, 0.0f );
+
+	for( const auto & p : d->m_order )
+	{
+		// Grown nodes don't move till the next generation or till
+		// the parent grows.
+		if( p->m_settled && ( !p->m_parent || p->m_parent->m_settled ) )
+			continue;
+
+		// Node grows in the spring.
+		const float g = qBound( 0.0f, ( age - p->m_growStart ) * 4.0f, 1.0f );
+		const float length = p->m_fromLength +
+			( p->m_length - p->m_fromLength ) * g;
+		const float radius = p->m_fromRadius +
+			( p->m_radius - p->m_fromRadius ) * g;
+
+		const QVector3D start = ( p->m_parent ? p->m_parent->m_endPos :
+			QVector3D() );
+
+		p->m_startPos = start;
+		p->m_endPos = start + p->m_direction * length;
+
+		auto * t = p->m_transform;
+		t->setTranslation( start + p->m_direction * ( length / 2.0f ) );
+		t->setRotation( QQuaternion::rotationTo( up, p->m_direction ) );
+		t->setScale3D( QVector3D( radius, length, radius ) );
+
+		p->m_settled = ( g >= 1.0f &&
+			( !p->m_parent || p->m_parent->m_settled ) );
+	}
+
+	d->updateLeafs( age );
+}
+
+void
+SkeletonEntity::setTessellation( int rings, int slices )
+{
+	for( const auto & p : d->m_order )
+		d->setMesh( *p, p->m_ratio, rings, slices );
+}
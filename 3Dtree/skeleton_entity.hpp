@@ -0,0 +1,75 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__SKELETON_ENTITY_HPP__INCLUDED
+#define TREE__SKELETON_ENTITY_HPP__INCLUDED
+
+// 3Dtree include.
+#include "growth_model.hpp"
+
+// Qt include.
+#include <Qt3DCore/QEntity>
+
+// C++ include.
+#include <memory>
+#include <vector>
+
+struct TreeContext;
+
+
+//
+// SkeletonEntity
+//
+
+class SkeletonEntityPrivate;
+
+//! Renders nodes of the growth engine with the same cones, material and
+//! leafs as Branch. Leafs grow on the tips in the year the nodes are set.
+class SkeletonEntity Q_DECL_FINAL
+	:	public Qt3DCore::QEntity
+{
+public:
+	explicit SkeletonEntity( TreeContext * context,
+		Qt3DCore::QEntity * parent = Q_NULLPTR );
+	~SkeletonEntity();
+
+	//! Set nodes of the new generation at the given age of the tree.
+	//! Parts and leafs of the previous generations are kept, count of
+	//! the rendered nodes is capped by the branch budget, older nodes
+	//! go first.
+	void setNodes( const std::vector< GrowthNode > & nodes, float age );
+
+	//! Apply growth of the given age.
+	void setAge( float age );
+
+	//! Set tessellation of the branches.
+	void setTessellation( int rings, int slices );
+
+private:
+	friend class SkeletonEntityPrivate;
+
+	Q_DISABLE_COPY( SkeletonEntity )
+
+	std::unique_ptr< SkeletonEntityPrivate > d;
+}; // class SkeletonEntity
+
+#endif // TREE__SKELETON_ENTITY_HPP__INCLUDED
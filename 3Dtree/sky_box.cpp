@@ -0,0 +1,119 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "sky_box.hpp"
+#include "tree_material.hpp"
+
+// Qt include.
+#include <Qt3DRender/QTextureLoader>
+#include <Qt3DRender/QMaterial>
+#include <Qt3DRender/QEffect>
+#include <Qt3DRender/QTechnique>
+#include <Qt3DRender/QRenderPass>
+#include <Qt3DRender/QParameter>
+#include <Qt3DRender/QCullFace>
+#include <Qt3DRender/QDepthTest>
+#include <Qt3DRender/QSeamlessCubemap>
+#include <Qt3DExtras/QCuboidMesh>
+
+#include <QUrl>
+#include <QSize>
+
+
+//! Add render states of the sky box to the pass of the technique.
+static Qt3DRender::QTechnique * skyBoxTechnique(
+	Qt3DRender::QTechnique * technique )
+{
+	Qt3DRender::QRenderPass * pass = technique->renderPasses().constFirst();
+
+	// Camera is inside of the cube.
+	auto * cullFace = new Qt3DRender::QCullFace( pass );
+	cullFace->setMode( Qt3DRender::QCullFace::Front );
+	pass->addRenderState( cullFace );
+
+	// Sky box is drawn on the far plane.
+	auto * depthTest = new Qt3DRender::QDepthTest( pass );
+	depthTest->setDepthFunction( Qt3DRender::QDepthTest::LessOrEqual );
+	pass->addRenderState( depthTest );
+
+	pass->addRenderState( new Qt3DRender::QSeamlessCubemap( pass ) );
+
+	return technique;
+}
+
+
+//
+// SkyBox
+//
+
+SkyBox::SkyBox( const QUrl & source, Qt3DCore::QNode * parent )
+	:	Qt3DCore::QEntity( parent )
+	,	m_texture( new Qt3DRender::QTextureLoader( this ) )
+{
+	m_texture->setMirrored( false );
+	m_texture->setGenerateMipMaps( false );
+	m_texture->setMinificationFilter(
+		Qt3DRender::QAbstractTexture::LinearMipMapLinear );
+	m_texture->setMagnificationFilter( Qt3DRender::QAbstractTexture::Linear );
+	m_texture->wrapMode()->setX( Qt3DRender::QTextureWrapMode::ClampToEdge );
+	m_texture->wrapMode()->setY( Qt3DRender::QTextureWrapMode::ClampToEdge );
+	m_texture->wrapMode()->setZ( Qt3DRender::QTextureWrapMode::ClampToEdge );
+	m_texture->setSource( source );
+
+	auto * effect = new Qt3DRender::QEffect( this );
+	effect->addTechnique( skyBoxTechnique( createTechnique(
+		Qt3DRender::QGraphicsApiFilter::OpenGL,
+		Qt3DRender::QGraphicsApiFilter::CoreProfile, 3, 1,
+		QStringLiteral( "skybox" ), effect ) ) );
+	effect->addTechnique( skyBoxTechnique( createTechnique(
+		Qt3DRender::QGraphicsApiFilter::OpenGL,
+		Qt3DRender::QGraphicsApiFilter::NoProfile, 2, 0,
+		QStringLiteral( "skybox_es2" ), effect ) ) );
+	effect->addTechnique( skyBoxTechnique( createTechnique(
+		Qt3DRender::QGraphicsApiFilter::OpenGLES,
+		Qt3DRender::QGraphicsApiFilter::NoProfile, 2, 0,
+		QStringLiteral( "skybox_es2" ), effect ) ) );
+
+	auto * material = new Qt3DRender::QMaterial( this );
+	material->addParameter( new Qt3DRender::QParameter(
+		QStringLiteral( "skyboxTexture" ), m_texture, material ) );
+	material->setEffect( effect );
+
+	auto * mesh = new Qt3DExtras::QCuboidMesh( this );
+	mesh->setXYMeshResolution( QSize( 2, 2 ) );
+	mesh->setXZMeshResolution( QSize( 2, 2 ) );
+	mesh->setYZMeshResolution( QSize( 2, 2 ) );
+
+	addComponent( mesh );
+	addComponent( material );
+}
+
+SkyBox::~SkyBox()
+{
+}
+
+Qt3DRender::QTextureLoader *
+SkyBox::texture() const
+{
+	return m_texture;
+}
@@ -0,0 +1,64 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__SKY_BOX_HPP__INCLUDED
+#define TREE__SKY_BOX_HPP__INCLUDED
+
+// Qt include.
+#include <Qt3DCore/QEntity>
+
+QT_BEGIN_NAMESPACE
+
+class QUrl;
+
+namespace Qt3DRender {
+	class QTextureLoader;
+}
+
+QT_END_NAMESPACE
+
+
+//
+// SkyBox
+//
+
+//! Sky box with cube map texture loaded from the DDS file. Status of the
+//! loading is available through texture().
+class SkyBox Q_DECL_FINAL
+	:	public Qt3DCore::QEntity
+{
+public:
+	//! \par source is URL of the DDS cube map.
+	SkyBox( const QUrl & source, Qt3DCore::QNode * parent = Q_NULLPTR );
+	~SkyBox();
+
+	//! \return Texture of the sky box.
+	Qt3DRender::QTextureLoader * texture() const;
+
+private:
+	//! Texture.
+	Qt3DRender::QTextureLoader * m_texture;
+
+	Q_DISABLE_COPY( SkyBox )
+}; // class SkyBox
+
+#endif // TREE__SKY_BOX_HPP__INCLUDED
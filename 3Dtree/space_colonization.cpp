@@ -0,0 +1,308 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "space_colonization.hpp"
+
+// Qt include.
+#include <QtConcurrent/QtConcurrentMap>
+
+// C++ include.
+#include <algorithm>
+#include <cmath>
+
+
+//! Count of attraction points.
+static const size_t c_attractorsCount = 4000;
+//! Max count of nodes, growth stops on it.
+static const size_t c_maxNodes = 100000;
+//! Count of steps of growth a year.
+static const int c_stepsPerYear = 4;
+//! Count of attraction points queried by one task.
+static const size_t c_chunkSize = 1024;
+//! Height of the trunk below the crown, in segments.
+static const float c_trunkHeight = 6.0f;
+//! Height of the crown, in segments.
+static const float c_crownHeight = 18.0f;
+//! Radius of the crown, in segments.
+static const float c_crownRadius = 9.0f;
+//! Influence distance, in segments.
+static const float c_influence = 4.0f;
+//! Kill distance, in segments.
+static const float c_kill = 1.5f;
+//! Weight of the pull up.
+static const float c_tropism = 0.15f;
+
+//! Nearest node isn't within the influence distance.
+static const qint32 c_noNode = -1;
+//! Node is within the kill distance.
+static const qint32 c_reached = -2;
+
+
+//
+// SpatialHash
+//
+
+SpatialHash::SpatialHash( float cellSize )
+	:	m_cellSize( cellSize )
+{
+}
+
+void
+SpatialHash::insert( qint32 index, const QVector3D & pos )
+{
+	m_cells[ key( cell( pos.x() ), cell( pos.y() ), cell( pos.z() ) ) ]
+		.push_back( index );
+}
+
+void
+SpatialHash::clear()
+{
+	m_cells.clear();
+}
+
+quint64
+SpatialHash::key( qint32 x, qint32 y, qint32 z )
+{
+	// 21 bits for every coordinate.
+	return ( (quint64) ( x & 0x1FFFFF ) << 42 ) |
+		( (quint64) ( y & 0x1FFFFF ) << 21 ) |
+		(quint64) ( z & 0x1FFFFF );
+}
+
+qint32
+SpatialHash::cell( float v ) const
+{
+	return (qint32) std::floor( v / m_cellSize );
+}
+
+
+//
+// SpaceColonizationEngine
+//
+
+SpaceColonizationEngine::SpaceColonizationEngine( quint32 seed,
+	const GrowthPolicy & policy )
+	:	m_policy( policy )
+	,	m_generator( seed )
+	,	m_segmentLength( qMax( 0.05f, policy.branchLength() ) )
+	,	m_influence( m_segmentLength * c_influence )
+	,	m_kill( m_segmentLength * c_kill )
+	,	m_hash( m_influence )
+	,	m_trunkTip( -1 )
+	,	m_generation( 0 )
+{
+	scatterAttractors();
+
+	// Trunk starts from the ground.
+	addNode( -1, QVector3D( 0.0f, 1.0f, 0.0f ), 0.0f );
+}
+
+void
+SpaceColonizationEngine::grow( int generation )
+{
+	for( ; m_generation < generation; ++m_generation )
+	{
+		for( int i = 0; i < c_stepsPerYear; ++i )
+		{
+			// Nodes produced this year grow in the spring.
+			if( !step( (float) m_generation ) )
+				break;
+		}
+	}
+
+	applyPipeModel( m_nodes, qMax( 0.005f, m_policy.branchRadiusDelta() ) );
+}
+
+const std::vector< GrowthNode > &
+SpaceColonizationEngine::nodes() const
+{
+	return m_nodes;
+}
+
+const std::vector< QVector3D > &
+SpaceColonizationEngine::attractors() const
+{
+	return m_attractors;
+}
+
+void
+SpaceColonizationEngine::scatterAttractors()
+{
+	const float radius = m_segmentLength * c_crownRadius;
+	const float halfHeight = m_segmentLength * c_crownHeight / 2.0f;
+	const QVector3D center( 0.0f,
+		m_segmentLength * c_trunkHeight + halfHeight, 0.0f );
+
+	std::uniform_real_distribution< float > dis( -1.0f, 1.0f );
+
+	m_attractors.reserve( c_attractorsCount );
+
+	// Uniform points in the ellipsoid.
+	while( m_attractors.size() < c_attractorsCount )
+	{
+		const QVector3D p( dis( m_generator ), dis( m_generator ),
+			dis( m_generator ) );
+
+		if( p.lengthSquared() <= 1.0f )
+			m_attractors.push_back( center +
+				QVector3D( p.x() * radius, p.y() * halfHeight, p.z() * radius ) );
+	}
+}
+
+bool
+SpaceColonizationEngine::step( float birth )
+{
+	if( m_nodes.size() >= c_maxNodes )
+		return false;
+
+	// Nearest node of every point, found in parallel, each task writes
+	// its own range.
+	std::vector< qint32 > nearest( m_attractors.size(), c_noNode );
+
+	std::vector< std::pair< size_t, size_t > > chunks;
+
+	for( size_t b = 0; b < m_attractors.size(); b += c_chunkSize )
+		chunks.push_back( { b, qMin( b + c_chunkSize, m_attractors.size() ) } );
+
+	const float influence = m_influence * m_influence;
+	const float kill = m_kill * m_kill;
+
+	auto query = [&] ( const std::pair< size_t, size_t > & c )
+	{
+		for( size_t i = c.first; i < c.second; ++i )
+		{
+			const QVector3D & a = m_attractors[ i ];
+			float best = influence;
+
+			m_hash.forEachNear( a, [&] ( qint32 n )
+			{
+				const float d = ( m_nodes[ n ].m_endPos - a ).lengthSquared();
+
+				if( d < best )
+				{
+					best = d;
+					nearest[ i ] = n;
+				}
+			} );
+
+			if( nearest[ i ] != c_noNode && best < kill )
+				nearest[ i ] = c_reached;
+		}
+	};
+
+	if( chunks.size() > 1 )
+		QtConcurrent::blockingMap( chunks, query );
+	else
+	{
+		for( const auto & c : chunks )
+			query( c );
+	}
+
+	std::vector< QVector3D > pull( m_nodes.size() );
+	std::vector< bool > pulled( m_nodes.size(), false );
+
+	for( size_t i = 0; i < m_attractors.size(); ++i )
+	{
+		const qint32 n = nearest[ i ];
+
+		if( n >= 0 )
+		{
+			pull[ n ] += ( m_attractors[ i ] - m_nodes[ n ].m_endPos ).normalized();
+			pulled[ n ] = true;
+		}
+	}
+
+	// Remove reached points.
+	size_t last = 0;
+
+	for( size_t i = 0; i < m_attractors.size(); ++i )
+	{
+		if( nearest[ i ] != c_reached )
+			m_attractors[ last++ ] = m_attractors[ i ];
+	}
+
+	m_attractors.resize( last );
+
+	bool grown = false;
+	const QVector3D up( 0.0f, 1.0f, 0.0f );
+	const size_t count = m_nodes.size();
+
+	for( size_t n = 0; n < count && m_nodes.size() < c_maxNodes; ++n )
+	{
+		if( !pulled[ n ] )
+			continue;
+
+		const QVector3D dir = pull[ n ].normalized() + up * c_tropism;
+
+		// Points on the opposite sides cancel each other.
+		if( dir.lengthSquared() < 0.0001f )
+			continue;
+
+		addNode( (qint32) n, dir.normalized(), birth );
+
+		grown = true;
+	}
+
+	// Trunk grows up till it reaches the crown.
+	if( !grown && !m_attractors.empty() &&
+		m_nodes[ m_trunkTip ].m_endPos.y() <
+			m_segmentLength * ( c_trunkHeight + c_crownHeight ) )
+	{
+		addNode( m_trunkTip, up, birth );
+
+		grown = true;
+	}
+
+	return grown;
+}
+
+void
+SpaceColonizationEngine::addNode( qint32 parent, const QVector3D & direction,
+	float birth )
+{
+	GrowthNode n;
+	n.m_parent = parent;
+	n.m_birth = birth;
+	n.m_length = m_segmentLength;
+	n.m_bottomRadius = 0.0f;
+	n.m_topRadius = 0.0f;
+	n.m_direction = direction;
+	n.m_startPos = ( parent < 0 ? QVector3D() : m_nodes[ parent ].m_endPos );
+	n.m_endPos = n.m_startPos + direction * m_segmentLength;
+	n.m_firstBranch = m_nodes.empty();
+	// Trunk continues with the first steep segment on its tip.
+	n.m_isTree = ( parent == m_trunkTip && direction.y() > 0.7f );
+	n.m_alive = true;
+
+	m_nodes.push_back( n );
+
+	const qint32 index = (qint32) m_nodes.size() - 1;
+
+	if( parent >= 0 )
+		m_nodes[ parent ].m_children.push_back( index );
+
+	if( n.m_isTree )
+		m_trunkTip = index;
+
+	m_hash.insert( index, n.m_endPos );
+}
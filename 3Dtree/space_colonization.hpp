@@ -0,0 +1,150 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__SPACE_COLONIZATION_HPP__INCLUDED
+#define TREE__SPACE_COLONIZATION_HPP__INCLUDED
+
+// 3Dtree include.
+#include "growth_engine.hpp"
+
+// C++ include.
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+
+//
+// SpatialHash
+//
+
+//! Uniform grid of points hashed by the cell. Points within the cell size
+//! of the given one are in the 27 cells around it, so the query doesn't
+//! depend on the count of points.
+class SpatialHash Q_DECL_FINAL {
+public:
+	explicit SpatialHash( float cellSize );
+
+	//! Insert point with the given index.
+	void insert( qint32 index, const QVector3D & pos );
+
+	//! Clear.
+	void clear();
+
+	//! Call \par func with indexes of the points in the cells around
+	//! \par pos. Points may be farther than the cell size.
+	template< typename Func >
+	void forEachNear( const QVector3D & pos, Func func ) const;
+
+private:
+	//! \return Key of the cell.
+	static quint64 key( qint32 x, qint32 y, qint32 z );
+	//! \return Coordinate of the cell.
+	qint32 cell( float v ) const;
+
+	//! Size of the cell.
+	float m_cellSize;
+	//! Cells.
+	std::unordered_map< quint64, std::vector< qint32 > > m_cells;
+}; // class SpatialHash
+
+template< typename Func >
+inline void
+SpatialHash::forEachNear( const QVector3D & pos, Func func ) const
+{
+	const qint32 x = cell( pos.x() );
+	const qint32 y = cell( pos.y() );
+	const qint32 z = cell( pos.z() );
+
+	for( qint32 i = x - 1; i <= x + 1; ++i )
+	{
+		for( qint32 j = y - 1; j <= y + 1; ++j )
+		{
+			for( qint32 k = z - 1; k <= z + 1; ++k )
+			{
+				const auto it = m_cells.find( key( i, j, k ) );
+
+				if( it != m_cells.cend() )
+				{
+					for( const auto & index : it->second )
+						func( index );
+				}
+			}
+		}
+	}
+}
+
+
+//
+// SpaceColonizationEngine
+//
+
+//! Grows the tree by space colonization. Attraction points fill the crown
+//! envelope, every step each point pulls the nearest node within the
+//! influence distance, pulled nodes grow a segment toward the mean
+//! direction of their points, and points are removed when a node comes
+//! within the kill distance. The trunk grows up till it reaches the crown.
+//!
+//! Nodes are kept in SpatialHash, so a step costs O(points + nodes).
+class SpaceColonizationEngine Q_DECL_FINAL
+	:	public GrowthEngine
+{
+public:
+	SpaceColonizationEngine( quint32 seed, const GrowthPolicy & policy );
+
+	void grow( int generation ) Q_DECL_OVERRIDE;
+
+	const std::vector< GrowthNode > & nodes() const Q_DECL_OVERRIDE;
+
+	//! \return Attraction points left.
+	const std::vector< QVector3D > & attractors() const;
+
+private:
+	//! Fill the crown with attraction points.
+	void scatterAttractors();
+	//! Make one step of growth. \return false if nothing has grown.
+	bool step( float birth );
+	//! Add node on the end of the parent.
+	void addNode( qint32 parent, const QVector3D & direction, float birth );
+
+	//! Policy.
+	GrowthPolicy m_policy;
+	//! Random numbers generator.
+	std::mt19937 m_generator;
+	//! Length of the segment.
+	float m_segmentLength;
+	//! Influence distance.
+	float m_influence;
+	//! Kill distance.
+	float m_kill;
+	//! Attraction points.
+	std::vector< QVector3D > m_attractors;
+	//! Nodes.
+	std::vector< GrowthNode > m_nodes;
+	//! End positions of the nodes.
+	SpatialHash m_hash;
+	//! Tip of the trunk.
+	qint32 m_trunkTip;
+	//! Generation.
+	int m_generation;
+}; // class SpaceColonizationEngine
+
+#endif // TREE__SPACE_COLONIZATION_HPP__INCLUDED
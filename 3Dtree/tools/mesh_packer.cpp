@@ -0,0 +1,198 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+	Converts Wavefront OBJ into C++ source with packed vertices and
+	indices, so meshes are compiled into the binary and no OBJ parsing
+	happens at startup.
+
+	Usage: mesh_packer <input.obj> <output.cpp> <name>
+
+	Vertices are interleaved position and normal, polygons are
+	triangulated as fans.
+*/
+
+// C++ include.
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+//! Vertex of the face: indices of position and normal.
+typedef std::pair< int, int > FaceVertex;
+
+
+//! \return Index in the array from OBJ index, which may be negative.
+static int resolve( int idx, std::size_t count )
+{
+	return ( idx < 0 ? (int) count + idx : idx - 1 );
+}
+
+//! Parse face vertex: v, v/t, v//n or v/t/n.
+static FaceVertex parseFaceVertex( const std::string & s,
+	std::size_t positions, std::size_t normals )
+{
+	int v = 0, n = 0;
+
+	const std::size_t first = s.find( '/' );
+
+	v = std::stoi( s.substr( 0, first ) );
+
+	if( first != std::string::npos )
+	{
+		const std::size_t second = s.find( '/', first + 1 );
+
+		if( second != std::string::npos && second + 1 < s.size() )
+			n = std::stoi( s.substr( second + 1 ) );
+	}
+
+	return FaceVertex( resolve( v, positions ),
+		( n != 0 ? resolve( n, normals ) : -1 ) );
+}
+
+int main( int argc, char ** argv )
+{
+	if( argc != 4 )
+	{
+		std::fprintf( stderr,
+			"Usage: mesh_packer <input.obj> <output.cpp> <name>\n" );
+
+		return 1;
+	}
+
+	std::ifstream in( argv[ 1 ] );
+
+	if( !in )
+	{
+		std::fprintf( stderr, "Unable to open %s\n", argv[ 1 ] );
+
+		return 1;
+	}
+
+	std::vector< float > positions;
+	std::vector< float > normals;
+	std::vector< float > vertices;
+	std::vector< unsigned int > indices;
+	std::map< FaceVertex, unsigned int > unique;
+
+	std::string line;
+
+	while( std::getline( in, line ) )
+	{
+		std::istringstream str( line );
+		std::string type;
+		str >> type;
+
+		if( type == "v" || type == "vn" )
+		{
+			float x = 0.0f, y = 0.0f, z = 0.0f;
+			str >> x >> y >> z;
+
+			auto & dest = ( type == "v" ? positions : normals );
+			dest.push_back( x );
+			dest.push_back( y );
+			dest.push_back( z );
+		}
+		else if( type == "f" )
+		{
+			std::vector< unsigned int > face;
+			std::string token;
+
+			while( str >> token )
+			{
+				const FaceVertex fv = parseFaceVertex( token,
+					positions.size() / 3, normals.size() / 3 );
+
+				auto it = unique.find( fv );
+
+				if( it == unique.end() )
+				{
+					const unsigned int idx =
+						(unsigned int) ( vertices.size() / 6 );
+
+					for( int i = 0; i < 3; ++i )
+						vertices.push_back( positions.at( fv.first * 3 + i ) );
+
+					for( int i = 0; i < 3; ++i )
+						vertices.push_back( fv.second >= 0 ?
+							normals.at( fv.second * 3 + i ) :
+							( i == 1 ? 1.0f : 0.0f ) );
+
+					it = unique.insert( std::make_pair( fv, idx ) ).first;
+				}
+
+				face.push_back( it->second );
+			}
+
+			for( std::size_t i = 2; i < face.size(); ++i )
+			{
+				indices.push_back( face[ 0 ] );
+				indices.push_back( face[ i - 1 ] );
+				indices.push_back( face[ i ] );
+			}
+		}
+	}
+
+	std::ofstream out( argv[ 2 ] );
+
+	if( !out )
+	{
+		std::fprintf( stderr, "Unable to write %s\n", argv[ 2 ] );
+
+		return 1;
+	}
+
+	const std::string name = argv[ 3 ];
+
+	out << "// Generated by mesh_packer from " << argv[ 1 ]
+		<< ", don't edit.\n\n"
+		<< "#include \"packed_mesh.hpp\"\n\n"
+		<< "static const float c_" << name << "Vertices[] = {\n";
+
+	out << std::fixed << std::setprecision( 6 );
+
+	for( std::size_t i = 0; i < vertices.size(); i += 6 )
+	{
+		out << "\t";
+
+		for( std::size_t j = 0; j < 6; ++j )
+			out << vertices[ i + j ] << ( j < 5 ? "f, " : "f,\n" );
+	}
+
+	out << "};\n\nstatic const quint32 c_" << name << "Indices[] = {\n";
+
+	for( std::size_t i = 0; i < indices.size(); i += 3 )
+		out << "\t" << indices[ i ] << ", " << indices[ i + 1 ] << ", "
+			<< indices[ i + 2 ] << ",\n";
+
+	out << "};\n\nconst PackedMeshData c_" << name << "MeshData = {\n"
+		<< "\tc_" << name << "Vertices, " << vertices.size() / 6 << ",\n"
+		<< "\tc_" << name << "Indices, " << indices.size() << "\n"
+		<< "};\n";
+
+	return 0;
+}
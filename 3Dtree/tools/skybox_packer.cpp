@@ -0,0 +1,442 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+	Converts six skybox TGA faces into DXT1 compressed, mipmapped DDS
+	cubemaps: the full one and the low resolution placeholder.
+
+	Usage: skybox_packer <base name> <output.dds> <placeholder.dds> <size>
+
+	Faces are read from <base name>_posx.tga, _negx, _posy, _negy, _posz
+	and _negz. Placeholder has the given size of the face.
+*/
+
+// C++ include.
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+//
+// Image
+//
+
+//! RGB image, rows from the top.
+struct Image {
+	int m_width;
+	int m_height;
+	std::vector< float > m_data;
+
+	float * pixel( int x, int y )
+	{
+		return &m_data[ ( y * m_width + x ) * 3 ];
+	}
+
+	const float * pixel( int x, int y ) const
+	{
+		return &m_data[ ( y * m_width + x ) * 3 ];
+	}
+}; // struct Image
+
+
+//! Read uncompressed or RLE true color TGA.
+static bool readTga( const std::string & fileName, Image & img )
+{
+	std::ifstream in( fileName, std::ios::binary );
+
+	if( !in )
+		return false;
+
+	unsigned char h[ 18 ];
+
+	if( !in.read( reinterpret_cast< char* > ( h ), 18 ) )
+		return false;
+
+	const int type = h[ 2 ];
+	const int bpp = h[ 16 ] / 8;
+
+	if( ( type != 2 && type != 10 ) || ( bpp != 3 && bpp != 4 ) )
+		return false;
+
+	img.m_width = h[ 12 ] | ( h[ 13 ] << 8 );
+	img.m_height = h[ 14 ] | ( h[ 15 ] << 8 );
+	img.m_data.resize( img.m_width * img.m_height * 3 );
+
+	in.ignore( h[ 0 ] );
+
+	const bool topDown = ( h[ 17 ] & 0x20 ) != 0;
+	const int count = img.m_width * img.m_height;
+
+	std::vector< unsigned char > bgr( count * bpp );
+
+	if( type == 2 )
+		in.read( reinterpret_cast< char* > ( bgr.data() ), bgr.size() );
+	else
+	{
+		for( int i = 0; i < count; )
+		{
+			const int packet = in.get();
+			const int n = ( packet & 0x7F ) + 1;
+
+			if( packet & 0x80 )
+			{
+				unsigned char p[ 4 ];
+				in.read( reinterpret_cast< char* > ( p ), bpp );
+
+				for( int j = 0; j < n && i < count; ++j, ++i )
+					std::copy( p, p + bpp, &bgr[ i * bpp ] );
+			}
+			else
+			{
+				const int m = std::min( n, count - i );
+
+				in.read( reinterpret_cast< char* > ( &bgr[ i * bpp ] ), m * bpp );
+				i += m;
+			}
+		}
+	}
+
+	if( !in )
+		return false;
+
+	for( int y = 0; y < img.m_height; ++y )
+	{
+		const int row = ( topDown ? y : img.m_height - 1 - y );
+
+		for( int x = 0; x < img.m_width; ++x )
+		{
+			const unsigned char * s = &bgr[ ( row * img.m_width + x ) * bpp ];
+			float * d = img.pixel( x, y );
+
+			d[ 0 ] = s[ 2 ];
+			d[ 1 ] = s[ 1 ];
+			d[ 2 ] = s[ 0 ];
+		}
+	}
+
+	return true;
+}
+
+//! \return Image of the half size, box filter.
+static Image halfSize( const Image & img )
+{
+	Image res;
+	res.m_width = std::max( 1, img.m_width / 2 );
+	res.m_height = std::max( 1, img.m_height / 2 );
+	res.m_data.resize( res.m_width * res.m_height * 3 );
+
+	for( int y = 0; y < res.m_height; ++y )
+	{
+		for( int x = 0; x < res.m_width; ++x )
+		{
+			const int x0 = std::min( x * 2, img.m_width - 1 );
+			const int x1 = std::min( x * 2 + 1, img.m_width - 1 );
+			const int y0 = std::min( y * 2, img.m_height - 1 );
+			const int y1 = std::min( y * 2 + 1, img.m_height - 1 );
+
+			for( int c = 0; c < 3; ++c )
+				res.pixel( x, y )[ c ] = ( img.pixel( x0, y0 )[ c ] +
+					img.pixel( x1, y0 )[ c ] + img.pixel( x0, y1 )[ c ] +
+					img.pixel( x1, y1 )[ c ] ) / 4.0f;
+		}
+	}
+
+	return res;
+}
+
+//! \return RGB 565 of the color.
+static std::uint16_t to565( const float * c )
+{
+	const int r = std::min( 31, std::max( 0, (int) ( c[ 0 ] * 31.0f / 255.0f + 0.5f ) ) );
+	const int g = std::min( 63, std::max( 0, (int) ( c[ 1 ] * 63.0f / 255.0f + 0.5f ) ) );
+	const int b = std::min( 31, std::max( 0, (int) ( c[ 2 ] * 31.0f / 255.0f + 0.5f ) ) );
+
+	return (std::uint16_t) ( ( r << 11 ) | ( g << 5 ) | b );
+}
+
+//! Decode RGB 565.
+static void from565( std::uint16_t v, float * c )
+{
+	c[ 0 ] = (float) ( ( v >> 11 ) & 31 ) * 255.0f / 31.0f;
+	c[ 1 ] = (float) ( ( v >> 5 ) & 63 ) * 255.0f / 63.0f;
+	c[ 2 ] = (float) ( v & 31 ) * 255.0f / 31.0f;
+}
+
+//! Compress 4x4 block into DXT1. Endpoints are extremes of the block
+//! along the diagonal of its bounding box.
+static void compressBlock( const float block[ 16 ][ 3 ], std::vector< char > & out )
+{
+	float lo[ 3 ] = { 255.0f, 255.0f, 255.0f };
+	float hi[ 3 ] = { 0.0f, 0.0f, 0.0f };
+
+	for( int i = 0; i < 16; ++i )
+	{
+		for( int c = 0; c < 3; ++c )
+		{
+			lo[ c ] = std::min( lo[ c ], block[ i ][ c ] );
+			hi[ c ] = std::max( hi[ c ], block[ i ][ c ] );
+		}
+	}
+
+	const float axis[ 3 ] = { hi[ 0 ] - lo[ 0 ], hi[ 1 ] - lo[ 1 ],
+		hi[ 2 ] - lo[ 2 ] };
+
+	int minIdx = 0, maxIdx = 0;
+	float minDot = 0.0f, maxDot = 0.0f;
+
+	for( int i = 0; i < 16; ++i )
+	{
+		const float d = block[ i ][ 0 ] * axis[ 0 ] + block[ i ][ 1 ] * axis[ 1 ] +
+			block[ i ][ 2 ] * axis[ 2 ];
+
+		if( i == 0 || d < minDot ) { minDot = d; minIdx = i; }
+		if( i == 0 || d > maxDot ) { maxDot = d; maxIdx = i; }
+	}
+
+	std::uint16_t c0 = to565( block[ maxIdx ] );
+	std::uint16_t c1 = to565( block[ minIdx ] );
+
+	// c0 > c1 selects four colors mode.
+	if( c0 < c1 )
+		std::swap( c0, c1 );
+
+	std::uint32_t indices = 0;
+
+	if( c0 != c1 )
+	{
+		float palette[ 4 ][ 3 ];
+		from565( c0, palette[ 0 ] );
+		from565( c1, palette[ 1 ] );
+
+		for( int c = 0; c < 3; ++c )
+		{
+			palette[ 2 ][ c ] = ( 2.0f * palette[ 0 ][ c ] + palette[ 1 ][ c ] ) / 3.0f;
+			palette[ 3 ][ c ] = ( palette[ 0 ][ c ] + 2.0f * palette[ 1 ][ c ] ) / 3.0f;
+		}
+
+		for( int i = 0; i < 16; ++i )
+		{
+			int best = 0;
+			float bestDist = 0.0f;
+
+			for( int p = 0; p < 4; ++p )
+			{
+				float dist = 0.0f;
+
+				for( int c = 0; c < 3; ++c )
+					dist += ( block[ i ][ c ] - palette[ p ][ c ] ) *
+						( block[ i ][ c ] - palette[ p ][ c ] );
+
+				if( p == 0 || dist < bestDist )
+				{
+					bestDist = dist;
+					best = p;
+				}
+			}
+
+			indices |= (std::uint32_t) best << ( i * 2 );
+		}
+	}
+
+	const std::uint32_t words[ 2 ] = { (std::uint32_t) c0 | ( (std::uint32_t) c1 << 16 ),
+		indices };
+
+	for( int w = 0; w < 2; ++w )
+		for( int b = 0; b < 4; ++b )
+			out.push_back( (char) ( ( words[ w ] >> ( b * 8 ) ) & 0xFF ) );
+}
+
+//! Compress image into DXT1.
+static void compress( const Image & img, std::vector< char > & out )
+{
+	for( int by = 0; by < img.m_height; by += 4 )
+	{
+		for( int bx = 0; bx < img.m_width; bx += 4 )
+		{
+			float block[ 16 ][ 3 ];
+
+			for( int y = 0; y < 4; ++y )
+				for( int x = 0; x < 4; ++x )
+				{
+					const float * p = img.pixel( std::min( bx + x, img.m_width - 1 ),
+						std::min( by + y, img.m_height - 1 ) );
+
+					std::copy( p, p + 3, block[ y * 4 + x ] );
+				}
+
+			compressBlock( block, out );
+		}
+	}
+}
+
+//! \return Count of mip levels down to 1x1.
+static int levelsCount( int size )
+{
+	int levels = 1;
+
+	while( size > 1 )
+	{
+		size /= 2;
+		++levels;
+	}
+
+	return levels;
+}
+
+//! Put little endian 32 bit value.
+static void put32( std::vector< char > & out, std::uint32_t v )
+{
+	for( int b = 0; b < 4; ++b )
+		out.push_back( (char) ( ( v >> ( b * 8 ) ) & 0xFF ) );
+}
+
+//! Write DXT1 cubemap with all mip levels.
+static bool writeDds( const std::string & fileName,
+	const std::vector< Image > & faces )
+{
+	const int size = faces.front().m_width;
+	const int levels = levelsCount( size );
+
+	std::vector< char > out;
+
+	out.insert( out.end(), { 'D', 'D', 'S', ' ' } );
+
+	// Header.
+	put32( out, 124 );
+	// Caps, height, width, pixel format, mipmap count, linear size.
+	put32( out, 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000 );
+	put32( out, size );
+	put32( out, size );
+	put32( out, std::max( 1, ( size + 3 ) / 4 ) * std::max( 1, ( size + 3 ) / 4 ) * 8 );
+	put32( out, 0 );
+	put32( out, levels );
+
+	for( int i = 0; i < 11; ++i )
+		put32( out, 0 );
+
+	// Pixel format: FourCC DXT1.
+	put32( out, 32 );
+	put32( out, 0x4 );
+	out.insert( out.end(), { 'D', 'X', 'T', '1' } );
+
+	for( int i = 0; i < 5; ++i )
+		put32( out, 0 );
+
+	// Complex, texture, mipmap.
+	put32( out, 0x8 | 0x1000 | 0x400000 );
+	// Cubemap with all faces.
+	put32( out, 0x200 | 0xFC00 );
+	put32( out, 0 );
+	put32( out, 0 );
+	put32( out, 0 );
+
+	for( const auto & face : faces )
+	{
+		Image level = face;
+
+		for( int l = 0; l < levels; ++l )
+		{
+			compress( level, out );
+
+			if( l < levels - 1 )
+				level = halfSize( level );
+		}
+	}
+
+	std::ofstream file( fileName, std::ios::binary );
+
+	if( !file )
+		return false;
+
+	file.write( out.data(), out.size() );
+
+	return (bool) file;
+}
+
+int main( int argc, char ** argv )
+{
+	if( argc != 5 )
+	{
+		std::fprintf( stderr, "Usage: skybox_packer <base name> <output.dds> "
+			"<placeholder.dds> <size>\n" );
+
+		return 1;
+	}
+
+	// Order of faces in DDS cubemap.
+	static const char * suffixes[] = { "_posx", "_negx", "_posy", "_negy",
+		"_posz", "_negz" };
+
+	std::vector< Image > faces;
+
+	for( const char * suffix : suffixes )
+	{
+		const std::string fileName = std::string( argv[ 1 ] ) + suffix + ".tga";
+
+		Image img;
+
+		if( !readTga( fileName, img ) || img.m_width != img.m_height )
+		{
+			std::fprintf( stderr, "Unable to read square TGA %s\n",
+				fileName.c_str() );
+
+			return 1;
+		}
+
+		if( !faces.empty() && img.m_width != faces.front().m_width )
+		{
+			std::fprintf( stderr, "Faces should have the same size\n" );
+
+			return 1;
+		}
+
+		faces.push_back( img );
+	}
+
+	if( !writeDds( argv[ 2 ], faces ) )
+	{
+		std::fprintf( stderr, "Unable to write %s\n", argv[ 2 ] );
+
+		return 1;
+	}
+
+	const int placeholderSize = std::max( 1, std::atoi( argv[ 4 ] ) );
+
+	for( auto & face : faces )
+	{
+		while( face.m_width > placeholderSize )
+			face = halfSize( face );
+	}
+
+	if( !writeDds( argv[ 3 ], faces ) )
+	{
+		std::fprintf( stderr, "Unable to write %s\n", argv[ 3 ] );
+
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,269 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "tree.hpp"
+#include "branch.hpp"
+#include "constants.hpp"
+#include "tree_context.hpp"
+#include "growth_engine.hpp"
+#include "skeleton_entity.hpp"
+#include "simulation_thread.hpp"
+#include "lifecycle_scheduler.hpp"
+
+// Qt include.
+#include <Qt3DCore/QTransform>
+
+// C++ include.
+#include <cmath>
+
+
+//
+// TreePrivate
+//
+
+class TreePrivate {
+public:
+	TreePrivate( const TreeContext & context, quint32 seed,
+		const QVector3D & pos, Tree * parent )
+		:	m_context( context )
+		,	m_pos( pos )
+		,	m_startPos( 0.0f, -0.5f, 0.0f )
+		,	m_endPos( 0.0f, 0.0f, 0.0f )
+		,	m_age( 0 )
+		,	m_currentAge( 0.0f )
+		,	m_root( Q_NULLPTR )
+		,	m_skeleton( Q_NULLPTR )
+		,	m_generation( 0 )
+		,	m_leafs( Q_NULLPTR )
+		,	q( parent )
+	{
+		m_context.m_generator.seed( seed );
+		m_context.m_scheduler = std::make_shared< LifecycleScheduler > ();
+	}
+
+	//! Init.
+	void init();
+	//! Request the generation of the engine for the given age and apply
+	//! the latest snapshot to the skeleton.
+	void updateSkeleton( float age );
+
+	//! Context.
+	TreeContext m_context;
+	//! Position.
+	QVector3D m_pos;
+	//! Start position of the trunk in the tree's coordinates.
+	QVector3D m_startPos;
+	//! End position of the trunk in the tree's coordinates.
+	QVector3D m_endPos;
+	//! Age.
+	quint16 m_age;
+	//! Age of the last simulation step.
+	float m_currentAge;
+	//! Root branch, null if the tree is grown by the engine.
+	Branch * m_root;
+	//! Simulation of the growth engine, null if branches spawn their
+	//! children themselves.
+	std::unique_ptr< GrowthSimulation > m_simulation;
+	//! Skeleton of the engine.
+	SkeletonEntity * m_skeleton;
+	//! Requested generation of the engine.
+	int m_generation;
+	//! Leafs entity.
+	Qt3DCore::QEntity * m_leafs;
+	//! Parent.
+	Tree * q;
+}; // class TreePrivate
+
+void
+TreePrivate::init()
+{
+	auto transform = std::make_unique< Qt3DCore::QTransform > ();
+	transform->setTranslation( m_pos );
+	q->addComponent( transform.release() );
+
+	m_leafs = new Qt3DCore::QEntity( q );
+
+	m_context.m_leafsParent = m_leafs;
+
+	auto engine = GrowthEngine::create( m_context.m_engine,
+		m_context.m_generator(), m_context.m_policy, m_context.m_enableDeath,
+		qRound( m_context.m_ticksPerYear ) );
+
+	if( engine )
+	{
+		m_simulation = std::make_unique< GrowthSimulation > ( std::move( engine ) );
+		m_skeleton = new SkeletonEntity( &m_context, q );
+
+		if( m_context.m_simulationThread )
+			m_context.m_simulationThread->add( m_simulation.get() );
+
+		updateSkeleton( 0.0f );
+
+		return;
+	}
+
+	m_root = new Branch( m_startPos, m_endPos, m_age,
+		m_context.m_policy.startBranchRadius(), true, true, &m_context, Q_NULLPTR, q, true );
+
+	m_root->setAge( 0.0f );
+	m_root->updatePosition();
+	m_root->placeLeafs();
+
+	if( m_context.m_useTubes )
+		m_root->updateTubes();
+}
+
+void
+TreePrivate::updateSkeleton( float age )
+{
+	// One generation a year, it starts to grow in the spring.
+	const int generation = (int) std::floor( age ) + 1;
+
+	if( generation > m_generation )
+	{
+		m_generation = generation;
+		m_simulation->request( generation );
+
+		if( m_context.m_simulationThread )
+			m_context.m_simulationThread->wake();
+		else
+			m_simulation->simulate();
+	}
+
+	// Skeleton shows the previous generation till the new one is ready.
+	if( m_simulation->update() )
+		m_skeleton->setNodes( m_simulation->snapshot().m_nodes, age );
+	else
+		m_skeleton->setAge( age );
+}
+
+
+//
+// Tree
+//
+
+Tree::Tree( const TreeContext & context, quint32 seed,
+	const QVector3D & pos, Qt3DCore::QEntity * parent )
+	:	Qt3DCore::QEntity( parent )
+	,	d( new TreePrivate( context, seed, pos, this ) )
+{
+	d->init();
+}
+
+Tree::~Tree()
+{
+	if( d->m_simulation && d->m_context.m_simulationThread )
+		d->m_context.m_simulationThread->remove( d->m_simulation.get() );
+
+	// Branches and leafs use context, so they should die before it.
+	while( !children().isEmpty() )
+		delete children().first();
+}
+
+const QVector3D &
+Tree::position() const
+{
+	return d->m_pos;
+}
+
+TreeContext &
+Tree::context()
+{
+	return d->m_context;
+}
+
+Branch *
+Tree::rootBranch() const
+{
+	return d->m_root;
+}
+
+void
+Tree::setAge( float age )
+{
+	d->m_currentAge = age;
+
+	if( d->m_simulation )
+	{
+		d->updateSkeleton( age );
+
+		return;
+	}
+
+	d->m_context.m_scheduler->setTime( age );
+
+	d->m_root->setAge( age );
+
+	d->m_context.m_scheduler->fire();
+
+	if( d->m_context.m_useTubes )
+		d->m_root->updateTubes();
+}
+
+void
+Tree::interpolate( float age )
+{
+	// After the spring growth of branches and leafs nothing changes till
+	// the next year, the simulation step has already applied it.
+	if( std::floor( age ) == std::floor( d->m_currentAge ) &&
+		age - std::floor( age ) > 0.5f )
+			return;
+
+	if( d->m_skeleton )
+	{
+		d->updateSkeleton( age );
+
+		return;
+	}
+
+	d->m_root->interpolate( age );
+
+	// Chains change only while they grow in the spring, age deltas of
+	// branches are whole years.
+	if( d->m_context.m_useTubes && age - std::floor( age ) <= 0.25f )
+		d->m_root->updateTubes();
+}
+
+void
+Tree::setQuality( const Quality & quality )
+{
+	if( quality.m_rings != d->m_context.m_quality.m_rings ||
+		quality.m_slices != d->m_context.m_quality.m_slices )
+	{
+		if( d->m_skeleton )
+			d->m_skeleton->setTessellation( quality.m_rings, quality.m_slices );
+		else
+			d->m_root->setTessellation( quality.m_rings, quality.m_slices );
+	}
+
+	d->m_context.m_quality = quality;
+}
+
+void
+Tree::setLeafsEnabled( bool on )
+{
+	d->m_leafs->setEnabled( on );
+
+	if( d->m_context.m_useHierarchy && d->m_root )
+		d->m_root->setLeafsEnabled( on );
+}
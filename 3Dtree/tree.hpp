@@ -0,0 +1,83 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__TREE_HPP__INCLUDED
+#define TREE__TREE_HPP__INCLUDED
+
+// Qt include.
+#include <Qt3DCore/QEntity>
+
+// C++ include.
+#include <memory>
+
+
+class Branch;
+struct TreeContext;
+struct Quality;
+
+
+//
+// Tree
+//
+
+class TreePrivate;
+
+//! Tree. Root entity of all branches and leafs of one tree, owns
+//! tree's context.
+class Tree Q_DECL_FINAL
+	:	public Qt3DCore::QEntity
+{
+public:
+	Tree( const TreeContext & context, quint32 seed,
+		const QVector3D & pos, Qt3DCore::QEntity * parent = Q_NULLPTR );
+	~Tree();
+
+	//! \return Position of the tree.
+	const QVector3D & position() const;
+
+	//! \return Context.
+	TreeContext & context();
+
+	//! \return Root branch, null if the tree is grown by the engine.
+	Branch * rootBranch() const;
+
+	//! Set age of the tree.
+	void setAge( float age );
+
+	//! Interpolate growth of the tree.
+	void interpolate( float age );
+
+	//! Set quality of the tree.
+	void setQuality( const Quality & quality );
+
+	//! Enable/disable leafs.
+	void setLeafsEnabled( bool on );
+
+private:
+	friend class TreePrivate;
+
+	Q_DISABLE_COPY( Tree )
+
+	std::unique_ptr< TreePrivate > d;
+}; // class Tree
+
+#endif // TREE__TREE_HPP__INCLUDED
@@ -0,0 +1,145 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__TREE_CONTEXT_HPP__INCLUDED
+#define TREE__TREE_CONTEXT_HPP__INCLUDED
+
+// 3Dtree include.
+#include "quality_governor.hpp"
+#include "growth_policy.hpp"
+#include "growth_engine.hpp"
+
+// Qt include.
+#include <QtGlobal>
+
+// C++ include.
+#include <random>
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+
+namespace Qt3DCore {
+	class QEntity;
+}
+
+namespace Qt3DRender {
+	class QGeometryRenderer;
+}
+
+class QTimer;
+
+QT_END_NAMESPACE
+
+class ConeCache;
+class TreeEffect;
+class TreeMaterial;
+class ChangeCounter;
+class LeafBudget;
+class BranchBudget;
+class SimulationThread;
+class LifecycleScheduler;
+
+
+//
+// TreeContext
+//
+
+//! Resources and settings shared by all branches and leafs of the tree.
+struct TreeContext Q_DECL_FINAL {
+	TreeContext()
+		:	m_effect( Q_NULLPTR )
+		,	m_material( Q_NULLPTR )
+		,	m_leafMesh( Q_NULLPTR )
+		,	m_animationTimer( Q_NULLPTR )
+		,	m_leafsParent( Q_NULLPTR )
+		,	m_entityCounter( Q_NULLPTR )
+		,	m_changeCounter( Q_NULLPTR )
+		,	m_useInstanceRendering( false )
+		,	m_enableDeath( true )
+		,	m_useTubes( false )
+		,	m_gpuGrowth( false )
+		,	m_gpuSeasons( false )
+		,	m_consolidateChains( false )
+		,	m_useHierarchy( false )
+		,	m_engine( GrowthEngine::Branches )
+		,	m_ticksPerYear( 600.0f )
+		,	m_quality( Quality::full() )
+	{
+	}
+
+	//! Effect of branches and leafs.
+	TreeEffect * m_effect;
+	//! Branch material.
+	TreeMaterial * m_material;
+	//! Leaf mesh.
+	Qt3DRender::QGeometryRenderer * m_leafMesh;
+	//! Cache of branch meshes, shared by all trees.
+	std::shared_ptr< ConeCache > m_coneCache;
+	//! Budget of leafs, shared by all trees.
+	std::shared_ptr< LeafBudget > m_leafBudget;
+	//! Budget of branches, shared by all trees.
+	std::shared_ptr< BranchBudget > m_branchBudget;
+	//! Thread of growth engines, shared by all trees. If null engines
+	//! grow on the GUI thread.
+	std::shared_ptr< SimulationThread > m_simulationThread;
+	//! Lifecycle events of branches and leafs, own for every tree.
+	std::shared_ptr< LifecycleScheduler > m_scheduler;
+	//! Animation timer.
+	QTimer * m_animationTimer;
+	//! Parent entity of the leafs, if null leafs are siblings of branches.
+	Qt3DCore::QEntity * m_leafsParent;
+	//! Entity counter.
+	quint64 * m_entityCounter;
+	//! Counter of property changes, null if changes aren't counted.
+	ChangeCounter * m_changeCounter;
+	//! Use instance rendering?
+	bool m_useInstanceRendering;
+	//! Enable death?
+	bool m_enableDeath;
+	//! Draw continuation chains with one tube instead of cones?
+	bool m_useTubes;
+	//! Evaluate growth of branches in the shader? Not used with tubes and
+	//! the hierarchy of entities.
+	bool m_gpuGrowth;
+	//! Evaluate seasons of leafs in the shader?
+	bool m_gpuSeasons;
+	//! Merge old continuation chains into single branches?
+	//! Not used with growth in the shader and the hierarchy of entities.
+	bool m_consolidateChains;
+	//! Make branches parents of their children and leafs, so transforms
+	//! are inherited by Qt3D? Not used with tubes and growth in the shader.
+	bool m_useHierarchy;
+	//! Growth engine of the skeleton. Leaf and branch budgets, tubes,
+	//! growth in the shader and the hierarchy aren't used with engines.
+	GrowthEngine::Type m_engine;
+	//! Count of simulation ticks a year, lifecycle events are sampled
+	//! as they were rolled every tick.
+	float m_ticksPerYear;
+	//! Quality of new branches and leafs.
+	Quality m_quality;
+	//! Growth policy.
+	GrowthPolicy m_policy;
+	//! Random numbers generator of the tree.
+	std::mt19937 m_generator;
+}; // struct TreeContext
+
+#endif // TREE__TREE_CONTEXT_HPP__INCLUDED
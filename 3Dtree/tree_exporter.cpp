@@ -0,0 +1,720 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "tree_exporter.hpp"
+#include "tree.hpp"
+#include "branch.hpp"
+#include "leaf.hpp"
+#include "packed_mesh.hpp"
+
+// Qt include.
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMatrix4x4>
+#include <QObject>
+#include <QQuaternion>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QUrl>
+#include <QtMath>
+
+// C++ include.
+#include <cmath>
+#include <limits>
+
+
+//! Size of the interleaved position and normal.
+static const quint64 c_vertexSize = 24;
+//! Size of translation, rotation and scale of the leaf instance.
+static const quint64 c_instanceSize = 40;
+//! glTF component type of float.
+static const int c_float = 5126;
+//! glTF component type of unsigned int.
+static const int c_uint = 5125;
+//! Size of the chunk on copying files.
+static const qint64 c_chunkSize = 64 * 1024;
+
+
+//
+// Vertex
+//
+
+//! Vertex of the mesh.
+struct Vertex Q_DECL_FINAL {
+	QVector3D m_pos;
+	QVector3D m_normal;
+}; // struct Vertex
+
+
+//
+// Bounds
+//
+
+//! Bounding box, glTF needs it for positions.
+struct Bounds Q_DECL_FINAL {
+	Bounds()
+		:	m_min( std::numeric_limits< float >::max(),
+				std::numeric_limits< float >::max(),
+				std::numeric_limits< float >::max() )
+		,	m_max( std::numeric_limits< float >::lowest(),
+				std::numeric_limits< float >::lowest(),
+				std::numeric_limits< float >::lowest() )
+	{
+	}
+
+	void add( const QVector3D & p )
+	{
+		m_min = QVector3D( qMin( m_min.x(), p.x() ), qMin( m_min.y(), p.y() ),
+			qMin( m_min.z(), p.z() ) );
+		m_max = QVector3D( qMax( m_max.x(), p.x() ), qMax( m_max.y(), p.y() ),
+			qMax( m_max.z(), p.z() ) );
+	}
+
+	void add( const Bounds & b )
+	{
+		add( b.m_min );
+		add( b.m_max );
+	}
+
+	QVector3D m_min;
+	QVector3D m_max;
+}; // struct Bounds
+
+
+//! Call \par func for the branch and all its children.
+template< typename Func >
+static inline void forEachBranch( const Branch * b, Func & func )
+{
+	func( b );
+
+	for( const auto & c : b->childBranches() )
+		forEachBranch( c, func );
+}
+
+//! \return Matrix of the tree.
+static inline QMatrix4x4 treeMatrix( const Tree * t )
+{
+	QMatrix4x4 m;
+	m.translate( t->position() );
+
+	return m;
+}
+
+//! \return Normal transformed with the normal matrix.
+static inline QVector3D mapNormal( const QMatrix3x3 & n, const QVector3D & v )
+{
+	return QVector3D(
+		n( 0, 0 ) * v.x() + n( 0, 1 ) * v.y() + n( 0, 2 ) * v.z(),
+		n( 1, 0 ) * v.x() + n( 1, 1 ) * v.y() + n( 1, 2 ) * v.z(),
+		n( 2, 0 ) * v.x() + n( 2, 1 ) * v.y() + n( 2, 2 ) * v.z() )
+			.normalized();
+}
+
+//! \return Vertices of the side of the branch: bottom ring, then top ring.
+static inline QVector< Vertex > branchRings( const Branch * b,
+	const QMatrix4x4 & tree, int slices )
+{
+	const QMatrix4x4 m = tree * b->meshMatrix();
+	const QMatrix3x3 n = m.normalMatrix();
+	const float bottom = b->meshBottomRadius();
+	const float top = b->meshTopRadius();
+
+	QVector< Vertex > res;
+	res.reserve( slices * 2 );
+
+	for( int ring = 0; ring < 2; ++ring )
+	{
+		const float r = ( ring ? top : bottom );
+		const float y = ( ring ? 0.5f : -0.5f );
+
+		for( int i = 0; i < slices; ++i )
+		{
+			const float a = 2.0f * (float) M_PI * (float) i / (float) slices;
+			const float c = std::cos( a );
+			const float s = std::sin( a );
+
+			// Mesh is of the unit length, so the slope is the radii delta.
+			res.append( { m.map( QVector3D( r * c, y, r * s ) ),
+				mapNormal( n, QVector3D( c, bottom - top, s ) ) } );
+		}
+	}
+
+	return res;
+}
+
+//! \return Indices of triangles of the side of the branch in its rings.
+static inline QVector< int > branchTriangles( int slices )
+{
+	QVector< int > res;
+	res.reserve( slices * 6 );
+
+	for( int i = 0; i < slices; ++i )
+	{
+		const int j = ( i + 1 ) % slices;
+
+		res << i << slices + i << j << j << slices + i << slices + j;
+	}
+
+	return res;
+}
+
+//! Write translation, rotation and scale of the leaf instance.
+static inline void writeInstance( QDataStream & s, const QMatrix4x4 & m )
+{
+	const QVector3D t = m.column( 3 ).toVector3D();
+	const QVector3D x = m.column( 0 ).toVector3D();
+	const QVector3D y = m.column( 1 ).toVector3D();
+	const QVector3D z = m.column( 2 ).toVector3D();
+	const QVector3D scale( x.length(), y.length(), z.length() );
+
+	QQuaternion r;
+
+	// Leaf of zero age has zero scale.
+	if( !qFuzzyIsNull( scale.x() ) && !qFuzzyIsNull( scale.y() ) &&
+		!qFuzzyIsNull( scale.z() ) )
+			r = QQuaternion::fromAxes( x / scale.x(), y / scale.y(),
+				z / scale.z() ).normalized();
+
+	s << t.x() << t.y() << t.z()
+		<< r.x() << r.y() << r.z() << r.scalar()
+		<< scale.x() << scale.y() << scale.z();
+}
+
+//! Set error. \return false.
+static inline bool fail( QString * error, const QString & msg )
+{
+	if( error )
+		*error = msg;
+
+	return false;
+}
+
+//! Remove partially written files and set error. \return false.
+static inline bool discard( QString * error, const QString & msg,
+	QFile & file, QFile * other = Q_NULLPTR )
+{
+	file.remove();
+
+	if( other )
+		other->remove();
+
+	return fail( error, msg );
+}
+
+//! \return Number for JSON.
+static inline QString number( float v )
+{
+	return QString::number( v, 'g', 9 );
+}
+
+//! \return Vector for JSON.
+static inline QString vector( const QVector3D & v )
+{
+	return QStringLiteral( "[%1,%2,%3]" )
+		.arg( number( v.x() ), number( v.y() ), number( v.z() ) );
+}
+
+//! \return Accessor for JSON.
+static inline QString accessor( int bufferView, quint64 offset, quint64 count,
+	int componentType, const QString & type,
+	const Bounds * bounds = Q_NULLPTR )
+{
+	QString res = QStringLiteral( "{\"bufferView\":%1,\"byteOffset\":%2,"
+		"\"componentType\":%3,\"count\":%4,\"type\":\"%5\"" )
+			.arg( bufferView ).arg( offset ).arg( componentType )
+			.arg( count ).arg( type );
+
+	if( bounds )
+		res.append( QStringLiteral( ",\"min\":%1,\"max\":%2" )
+			.arg( vector( bounds->m_min ), vector( bounds->m_max ) ) );
+
+	res.append( QLatin1Char( '}' ) );
+
+	return res;
+}
+
+//! \return Buffer view for JSON.
+static inline QString bufferView( quint64 offset, quint64 length,
+	quint64 stride, int target )
+{
+	QString res = QStringLiteral(
+		"{\"buffer\":0,\"byteOffset\":%1,\"byteLength\":%2" )
+			.arg( offset ).arg( length );
+
+	if( stride )
+		res.append( QStringLiteral( ",\"byteStride\":%1" ).arg( stride ) );
+
+	if( target )
+		res.append( QStringLiteral( ",\"target\":%1" ).arg( target ) );
+
+	res.append( QLatin1Char( '}' ) );
+
+	return res;
+}
+
+//! Copy the rest of \par from to \par to. \return Is copied successfully?
+static inline bool copy( QIODevice & from, QIODevice & to )
+{
+	while( !from.atEnd() )
+	{
+		const QByteArray chunk = from.read( c_chunkSize );
+
+		if( chunk.isEmpty() || to.write( chunk ) != chunk.size() )
+			return false;
+	}
+
+	return true;
+}
+
+
+//
+// TreeExporter
+//
+
+TreeExporter::TreeExporter( Format format )
+	:	m_format( format )
+	,	m_slices( 16 )
+	,	m_mergeBranches( false )
+{
+}
+
+TreeExporter::Format
+TreeExporter::formatOf( const QString & fileName )
+{
+	if( QFileInfo( fileName ).suffix().compare( QStringLiteral( "obj" ),
+		Qt::CaseInsensitive ) == 0 )
+			return Obj;
+	else
+		return Gltf;
+}
+
+void
+TreeExporter::setSlices( int slices )
+{
+	m_slices = qMax( 3, slices );
+}
+
+void
+TreeExporter::setMergeBranches( bool on )
+{
+	m_mergeBranches = on;
+}
+
+bool
+TreeExporter::exportTrees( const QVector< Tree* > & trees,
+	const QString & fileName, QString * error ) const
+{
+	switch( m_format )
+	{
+		case Obj :
+			return exportObj( trees, fileName, error );
+
+		default :
+			return exportGltf( trees, fileName, error );
+	}
+}
+
+bool
+TreeExporter::exportGltf( const QVector< Tree* > & trees,
+	const QString & fileName, QString * error ) const
+{
+	const QFileInfo info( fileName );
+	const QString binName = info.completeBaseName() + QStringLiteral( ".bin" );
+
+	QFile json( fileName );
+	QFile bin( info.dir().filePath( binName ) );
+	// Leaf instances and accessors of branches are known after the walk,
+	// they wait in temporary files.
+	QTemporaryFile instances;
+	QTemporaryFile accessors;
+
+	if( !json.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+		return fail( error, QObject::tr( "Unable to open %1." ).arg( fileName ) );
+
+	if( !bin.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+		return discard( error,
+			QObject::tr( "Unable to open %1." ).arg( bin.fileName() ), json );
+
+	if( !instances.open() || !accessors.open() )
+		return discard( error,
+			QObject::tr( "Unable to create temporary file." ), json, &bin );
+
+	QDataStream binStream( &bin );
+	binStream.setByteOrder( QDataStream::LittleEndian );
+	binStream.setFloatingPointPrecision( QDataStream::SinglePrecision );
+
+	QDataStream instancesStream( &instances );
+	instancesStream.setByteOrder( QDataStream::LittleEndian );
+	instancesStream.setFloatingPointPrecision( QDataStream::SinglePrecision );
+
+	QTextStream accessorsStream( &accessors );
+
+	const QVector< int > triangles = branchTriangles( m_slices );
+
+	quint64 branchVertices = 0;
+	quint64 branches = 0;
+	quint64 leafs = 0;
+	Bounds all;
+
+	// Branches are written right into the buffer.
+	for( const auto & t : trees )
+	{
+		const QMatrix4x4 tree = treeMatrix( t );
+
+		auto write = [&] ( const Branch * b )
+		{
+			const QVector< Vertex > rings = branchRings( b, tree, m_slices );
+			Bounds bounds;
+
+			for( const auto & i : triangles )
+			{
+				const Vertex & v = rings.at( i );
+
+				binStream << v.m_pos.x() << v.m_pos.y() << v.m_pos.z()
+					<< v.m_normal.x() << v.m_normal.y() << v.m_normal.z();
+
+				bounds.add( v.m_pos );
+			}
+
+			if( !m_mergeBranches )
+				accessorsStream << ( branches ? "," : "" )
+					<< accessor( 0, branchVertices * c_vertexSize,
+						triangles.size(), c_float, QStringLiteral( "VEC3" ),
+						&bounds )
+					<< ","
+					<< accessor( 0, branchVertices * c_vertexSize + 12,
+						triangles.size(), c_float, QStringLiteral( "VEC3" ) );
+
+			all.add( bounds );
+
+			branchVertices += triangles.size();
+			++branches;
+
+			const auto branchLeafs = b->leafs();
+
+			for( const auto & l : branchLeafs )
+			{
+				writeInstance( instancesStream, tree * l->matrix() );
+
+				++leafs;
+			}
+		};
+
+		if( t->rootBranch() )
+			forEachBranch( t->rootBranch(), write );
+	}
+
+	if( !branches )
+		return discard( error, QObject::tr( "Nothing to export." ),
+			json, &bin );
+
+	if( m_mergeBranches )
+		accessorsStream
+			<< accessor( 0, 0, branchVertices, c_float,
+				QStringLiteral( "VEC3" ), &all )
+			<< ","
+			<< accessor( 0, 12, branchVertices, c_float,
+				QStringLiteral( "VEC3" ) );
+
+	accessorsStream.flush();
+
+	// Leaf mesh is shared by all instances.
+	const PackedMeshData & leaf = c_leafMeshData;
+	Bounds leafBounds;
+
+	if( leafs )
+	{
+		for( quint32 i = 0; i < leaf.m_verticesCount * 6; ++i )
+			binStream << leaf.m_vertices[ i ];
+
+		for( quint32 i = 0; i < leaf.m_verticesCount; ++i )
+			leafBounds.add( QVector3D( leaf.m_vertices[ i * 6 ],
+				leaf.m_vertices[ i * 6 + 1 ], leaf.m_vertices[ i * 6 + 2 ] ) );
+
+		for( quint32 i = 0; i < leaf.m_indicesCount; ++i )
+			binStream << leaf.m_indices[ i ];
+
+		instances.seek( 0 );
+
+		if( !copy( instances, bin ) )
+			return discard( error,
+				QObject::tr( "Unable to write %1." ).arg( bin.fileName() ),
+				json, &bin );
+	}
+
+	if( binStream.status() != QDataStream::Ok ||
+		instancesStream.status() != QDataStream::Ok )
+			return discard( error,
+				QObject::tr( "Unable to write %1." ).arg( bin.fileName() ),
+				json, &bin );
+
+	const quint64 branchesSize = branchVertices * c_vertexSize;
+	const quint64 leafVerticesSize = leaf.m_verticesCount * c_vertexSize;
+	const quint64 leafIndicesSize = leaf.m_indicesCount * 4;
+	const quint64 instancesSize = leafs * c_instanceSize;
+	const quint64 size = branchesSize + ( leafs ? leafVerticesSize +
+		leafIndicesSize + instancesSize : 0 );
+
+	const quint64 branchMeshes = ( m_mergeBranches ? 1 : branches );
+	const quint64 leafAccessor = branchMeshes * 2;
+
+	QTextStream out( &json );
+
+	out << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"3Dtree\"},";
+
+	if( leafs )
+		out << "\"extensionsUsed\":[\"EXT_mesh_gpu_instancing\"],";
+
+	// URI is relative reference, so spaces and non-ASCII characters of the
+	// file name are percent-encoded.
+	out << "\"buffers\":[{\"uri\":\""
+		<< QString::fromLatin1( QUrl::toPercentEncoding( binName ) )
+		<< "\",\"byteLength\":"
+		<< size << "}],";
+
+	out << "\"bufferViews\":[" << bufferView( 0, branchesSize, c_vertexSize,
+		34962 );
+
+	if( leafs )
+		out << "," << bufferView( branchesSize, leafVerticesSize, c_vertexSize,
+				34962 )
+			<< "," << bufferView( branchesSize + leafVerticesSize,
+				leafIndicesSize, 0, 34963 )
+			<< "," << bufferView( branchesSize + leafVerticesSize +
+				leafIndicesSize, instancesSize, c_instanceSize, 0 );
+
+	out << "],\"accessors\":[";
+	out.flush();
+
+	accessors.seek( 0 );
+
+	if( !copy( accessors, json ) )
+		return discard( error,
+			QObject::tr( "Unable to write %1." ).arg( fileName ), json, &bin );
+
+	if( leafs )
+		out << "," << accessor( 1, 0, leaf.m_verticesCount, c_float,
+				QStringLiteral( "VEC3" ), &leafBounds )
+			<< "," << accessor( 1, 12, leaf.m_verticesCount, c_float,
+				QStringLiteral( "VEC3" ) )
+			<< "," << accessor( 2, 0, leaf.m_indicesCount, c_uint,
+				QStringLiteral( "SCALAR" ) )
+			<< "," << accessor( 3, 0, leafs, c_float, QStringLiteral( "VEC3" ) )
+			<< "," << accessor( 3, 12, leafs, c_float, QStringLiteral( "VEC4" ) )
+			<< "," << accessor( 3, 28, leafs, c_float, QStringLiteral( "VEC3" ) );
+
+	out << "],\"materials\":["
+		"{\"name\":\"bark\",\"pbrMetallicRoughness\":{\"baseColorFactor\":"
+		"[0.16,0.075,0,1],\"metallicFactor\":0,\"roughnessFactor\":1}},"
+		"{\"name\":\"leaf\",\"doubleSided\":true,\"pbrMetallicRoughness\":"
+		"{\"baseColorFactor\":[0,0.5,0,1],\"metallicFactor\":0,"
+		"\"roughnessFactor\":0.8}}],";
+
+	out << "\"meshes\":[";
+
+	for( quint64 i = 0; i < branchMeshes; ++i )
+		out << ( i ? "," : "" ) << "{\"primitives\":[{\"attributes\":"
+			"{\"POSITION\":" << i * 2 << ",\"NORMAL\":" << i * 2 + 1
+			<< "},\"material\":0}]}";
+
+	if( leafs )
+		out << ",{\"primitives\":[{\"attributes\":{\"POSITION\":"
+			<< leafAccessor << ",\"NORMAL\":" << leafAccessor + 1
+			<< "},\"indices\":" << leafAccessor + 2 << ",\"material\":1}]}";
+
+	out << "],\"nodes\":[";
+
+	if( m_mergeBranches )
+		out << "{\"name\":\"branches\",\"mesh\":0}";
+	else
+	{
+		for( quint64 i = 0; i < branchMeshes; ++i )
+			out << ( i ? "," : "" ) << "{\"name\":\"branch_" << i
+				<< "\",\"mesh\":" << i << "}";
+	}
+
+	if( leafs )
+		out << ",{\"name\":\"leafs\",\"mesh\":" << branchMeshes
+			<< ",\"extensions\":{\"EXT_mesh_gpu_instancing\":{\"attributes\":"
+			"{\"TRANSLATION\":" << leafAccessor + 3 << ",\"ROTATION\":"
+			<< leafAccessor + 4 << ",\"SCALE\":" << leafAccessor + 5 << "}}}}";
+
+	out << "],\"scenes\":[{\"nodes\":[";
+
+	const quint64 nodes = branchMeshes + ( leafs ? 1 : 0 );
+
+	for( quint64 i = 0; i < nodes; ++i )
+		out << ( i ? "," : "" ) << i;
+
+	out << "]}],\"scene\":0}\n";
+	out.flush();
+
+	if( out.status() != QTextStream::Ok )
+		return discard( error,
+			QObject::tr( "Unable to write %1." ).arg( fileName ), json, &bin );
+
+	return true;
+}
+
+bool
+TreeExporter::exportObj( const QVector< Tree* > & trees,
+	const QString & fileName, QString * error ) const
+{
+	QFile file( fileName );
+
+	if( !file.open( QIODevice::WriteOnly | QIODevice::Truncate |
+		QIODevice::Text ) )
+			return fail( error,
+				QObject::tr( "Unable to open %1." ).arg( fileName ) );
+
+	QTextStream out( &file );
+	out.setRealNumberPrecision( 7 );
+
+	out << "# Exported by 3Dtree\n";
+
+	const QVector< int > triangles = branchTriangles( m_slices );
+
+	quint64 vertices = 0;
+	quint64 branches = 0;
+
+	if( m_mergeBranches )
+		out << "o branches\n";
+
+	// OBJ has no instancing, so leafs are written in the second walk to
+	// keep them in one object.
+	for( const auto & t : trees )
+	{
+		const QMatrix4x4 tree = treeMatrix( t );
+
+		auto write = [&] ( const Branch * b )
+		{
+			if( !m_mergeBranches )
+				out << "o branch_" << branches << "\n";
+
+			const QVector< Vertex > rings = branchRings( b, tree, m_slices );
+
+			for( const auto & v : rings )
+				out << "v " << v.m_pos.x() << " " << v.m_pos.y() << " "
+					<< v.m_pos.z() << "\n";
+
+			for( const auto & v : rings )
+				out << "vn " << v.m_normal.x() << " " << v.m_normal.y() << " "
+					<< v.m_normal.z() << "\n";
+
+			for( int i = 0; i < triangles.size(); i += 3 )
+			{
+				out << "f";
+
+				for( int j = i; j < i + 3; ++j )
+				{
+					const quint64 idx = vertices + triangles.at( j ) + 1;
+
+					out << " " << idx << "//" << idx;
+				}
+
+				out << "\n";
+			}
+
+			vertices += rings.size();
+			++branches;
+		};
+
+		if( t->rootBranch() )
+			forEachBranch( t->rootBranch(), write );
+	}
+
+	const PackedMeshData & leaf = c_leafMeshData;
+	bool leafsStarted = false;
+
+	for( const auto & t : trees )
+	{
+		const QMatrix4x4 tree = treeMatrix( t );
+
+		auto write = [&] ( const Branch * b )
+		{
+			const auto branchLeafs = b->leafs();
+
+			for( const auto & l : branchLeafs )
+			{
+				if( !leafsStarted )
+				{
+					out << "o leafs\n";
+
+					leafsStarted = true;
+				}
+
+				const QMatrix4x4 m = tree * l->matrix();
+				const QMatrix3x3 n = m.normalMatrix();
+
+				for( quint32 i = 0; i < leaf.m_verticesCount; ++i )
+				{
+					const float * v = leaf.m_vertices + i * 6;
+					const QVector3D p = m.map( QVector3D( v[ 0 ], v[ 1 ], v[ 2 ] ) );
+
+					out << "v " << p.x() << " " << p.y() << " " << p.z() << "\n";
+				}
+
+				for( quint32 i = 0; i < leaf.m_verticesCount; ++i )
+				{
+					const float * v = leaf.m_vertices + i * 6;
+					const QVector3D p = mapNormal( n,
+						QVector3D( v[ 3 ], v[ 4 ], v[ 5 ] ) );
+
+					out << "vn " << p.x() << " " << p.y() << " " << p.z() << "\n";
+				}
+
+				for( quint32 i = 0; i + 2 < leaf.m_indicesCount; i += 3 )
+				{
+					out << "f";
+
+					for( quint32 j = i; j < i + 3; ++j )
+					{
+						const quint64 idx = vertices + leaf.m_indices[ j ] + 1;
+
+						out << " " << idx << "//" << idx;
+					}
+
+					out << "\n";
+				}
+
+				vertices += leaf.m_verticesCount;
+			}
+		};
+
+		if( t->rootBranch() )
+			forEachBranch( t->rootBranch(), write );
+	}
+
+	out.flush();
+
+	if( out.status() != QTextStream::Ok )
+		return discard( error,
+			QObject::tr( "Unable to write %1." ).arg( fileName ), file );
+
+	if( !branches )
+		return discard( error, QObject::tr( "Nothing to export." ), file );
+
+	return true;
+}
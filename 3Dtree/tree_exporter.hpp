@@ -0,0 +1,82 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__TREE_EXPORTER_HPP__INCLUDED
+#define TREE__TREE_EXPORTER_HPP__INCLUDED
+
+// Qt include.
+#include <QVector>
+#include <QString>
+
+
+class Tree;
+
+
+//
+// TreeExporter
+//
+
+//! Exports grown trees. Geometry is streamed into the file while trees
+//! are walked, so no copy of the whole mesh is kept in memory.
+class TreeExporter Q_DECL_FINAL {
+public:
+	//! Format of the file.
+	enum Format {
+		//! glTF 2.0 with external binary buffer. Leafs are instanced with
+		//! EXT_mesh_gpu_instancing.
+		Gltf,
+		//! Wavefront OBJ.
+		Obj
+	}; // enum Format
+
+	explicit TreeExporter( Format format );
+
+	//! \return Format by the extension of the file.
+	static Format formatOf( const QString & fileName );
+
+	//! Set count of slices of branches.
+	void setSlices( int slices );
+
+	//! Merge all branches into one mesh? Otherwise every branch is a node.
+	void setMergeBranches( bool on );
+
+	//! Export trees. \return Is export successful?
+	bool exportTrees( const QVector< Tree* > & trees,
+		const QString & fileName, QString * error = Q_NULLPTR ) const;
+
+private:
+	//! Export glTF.
+	bool exportGltf( const QVector< Tree* > & trees,
+		const QString & fileName, QString * error ) const;
+	//! Export OBJ.
+	bool exportObj( const QVector< Tree* > & trees,
+		const QString & fileName, QString * error ) const;
+
+	//! Format.
+	Format m_format;
+	//! Count of slices of branches.
+	int m_slices;
+	//! Merge branches?
+	bool m_mergeBranches;
+}; // class TreeExporter
+
+#endif // TREE__TREE_EXPORTER_HPP__INCLUDED
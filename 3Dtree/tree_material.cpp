@@ -0,0 +1,261 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "tree_material.hpp"
+#include "growth_policy.hpp"
+
+// Qt include.
+#include <Qt3DRender/QParameter>
+#include <Qt3DRender/QTechnique>
+#include <Qt3DRender/QRenderPass>
+#include <Qt3DRender/QShaderProgram>
+#include <Qt3DRender/QFilterKey>
+
+#include <QColor>
+#include <QUrl>
+#include <QVector3D>
+
+
+//
+// createTechnique
+//
+
+Qt3DRender::QTechnique *
+createTechnique(
+	Qt3DRender::QGraphicsApiFilter::Api api,
+	Qt3DRender::QGraphicsApiFilter::OpenGLProfile profile,
+	int major, int minor, const QString & shaders,
+	Qt3DCore::QNode * parent )
+{
+	auto * technique = new Qt3DRender::QTechnique( parent );
+	technique->graphicsApiFilter()->setApi( api );
+	technique->graphicsApiFilter()->setProfile( profile );
+	technique->graphicsApiFilter()->setMajorVersion( major );
+	technique->graphicsApiFilter()->setMinorVersion( minor );
+
+	auto * filterKey = new Qt3DRender::QFilterKey( technique );
+	filterKey->setName( QStringLiteral( "renderingStyle" ) );
+	filterKey->setValue( QStringLiteral( "forward" ) );
+	technique->addFilterKey( filterKey );
+
+	auto * program = new Qt3DRender::QShaderProgram( technique );
+	program->setVertexShaderCode( Qt3DRender::QShaderProgram::loadSource(
+		QUrl( QStringLiteral( "qrc:/res/shaders/%1.vert" ).arg( shaders ) ) ) );
+	program->setFragmentShaderCode( Qt3DRender::QShaderProgram::loadSource(
+		QUrl( QStringLiteral( "qrc:/res/shaders/%1.frag" ).arg( shaders ) ) ) );
+
+	auto * pass = new Qt3DRender::QRenderPass( technique );
+	pass->setShaderProgram( program );
+	technique->addRenderPass( pass );
+
+	return technique;
+}
+
+
+//
+// TreeEffect
+//
+
+TreeEffect::TreeEffect( Qt3DCore::QNode * parent )
+	:	Qt3DRender::QEffect( parent )
+	,	m_time( new Qt3DRender::QParameter( QStringLiteral( "windTime" ),
+			0.0f, this ) )
+	,	m_windDirection( new Qt3DRender::QParameter(
+			QStringLiteral( "windDirection" ), QVector3D( 1.0f, 0.0f, 0.0f ),
+			this ) )
+	,	m_windStrength( new Qt3DRender::QParameter(
+			QStringLiteral( "windStrength" ), 0.0f, this ) )
+	,	m_lightPosition( new Qt3DRender::QParameter(
+			QStringLiteral( "lightPosition" ), QVector3D(), this ) )
+	,	m_lightIntensity( new Qt3DRender::QParameter(
+			QStringLiteral( "lightIntensity" ), 1.0f, this ) )
+	,	m_age( new Qt3DRender::QParameter( QStringLiteral( "treeAge" ),
+			0.0f, this ) )
+	,	m_branchScale( new Qt3DRender::QParameter(
+			QStringLiteral( "branchScale" ), c_branchScale, this ) )
+	,	m_branchLengthMultiplicator( new Qt3DRender::QParameter(
+			QStringLiteral( "branchLengthMultiplicator" ),
+			c_branchLengthMultiplicator, this ) )
+	,	m_branchSlower( new Qt3DRender::QParameter(
+			QStringLiteral( "branchSlower" ), c_branchSlower, this ) )
+	,	m_firstBranchGrowsFaster( new Qt3DRender::QParameter(
+			QStringLiteral( "firstBranchGrowsFaster" ),
+			c_firstBranchGrowsFaster, this ) )
+{
+	addParameter( m_time );
+	addParameter( m_windDirection );
+	addParameter( m_windStrength );
+	addParameter( m_lightPosition );
+	addParameter( m_lightIntensity );
+	addParameter( m_age );
+	addParameter( m_branchScale );
+	addParameter( m_branchLengthMultiplicator );
+	addParameter( m_branchSlower );
+	addParameter( m_firstBranchGrowsFaster );
+
+	// Software GL provides at least OpenGL 2.0, so there is always
+	// a technique to fall back to.
+	addTechnique( createTechnique( Qt3DRender::QGraphicsApiFilter::OpenGL,
+		Qt3DRender::QGraphicsApiFilter::CoreProfile, 3, 1,
+		QStringLiteral( "tree" ), this ) );
+	addTechnique( createTechnique( Qt3DRender::QGraphicsApiFilter::OpenGL,
+		Qt3DRender::QGraphicsApiFilter::NoProfile, 2, 0,
+		QStringLiteral( "tree_es2" ), this ) );
+	addTechnique( createTechnique( Qt3DRender::QGraphicsApiFilter::OpenGLES,
+		Qt3DRender::QGraphicsApiFilter::NoProfile, 2, 0,
+		QStringLiteral( "tree_es2" ), this ) );
+}
+
+TreeEffect::~TreeEffect()
+{
+}
+
+void
+TreeEffect::setTime( float seconds )
+{
+	m_time->setValue( seconds );
+}
+
+void
+TreeEffect::setWind( const QVector3D & direction, float strength )
+{
+	m_windDirection->setValue( direction.normalized() );
+	m_windStrength->setValue( strength );
+}
+
+void
+TreeEffect::setLightPosition( const QVector3D & pos )
+{
+	m_lightPosition->setValue( pos );
+}
+
+void
+TreeEffect::setLightIntensity( float intensity )
+{
+	m_lightIntensity->setValue( intensity );
+}
+
+void
+TreeEffect::setAge( float age )
+{
+	m_age->setValue( age );
+}
+
+void
+TreeEffect::setPolicy( const GrowthPolicy & policy )
+{
+	m_branchScale->setValue( policy.branchScale() );
+	m_branchLengthMultiplicator->setValue( policy.branchLengthMultiplicator() );
+	m_branchSlower->setValue( policy.branchSlower() );
+	m_firstBranchGrowsFaster->setValue( policy.firstBranchGrowsFaster() );
+}
+
+
+//
+// TreeMaterial
+//
+
+TreeMaterial::TreeMaterial( TreeEffect * effect, Qt3DCore::QNode * parent )
+	:	Qt3DRender::QMaterial( parent )
+	,	m_diffuse( new Qt3DRender::QParameter( QStringLiteral( "kd" ),
+			QColor( Qt::white ), this ) )
+	,	m_flutter( new Qt3DRender::QParameter( QStringLiteral( "flutter" ),
+			0.0f, this ) )
+	,	m_birthAge( new Qt3DRender::QParameter( QStringLiteral( "birthAge" ),
+			0.0f, this ) )
+	,	m_length( new Qt3DRender::QParameter( QStringLiteral( "branchLength" ),
+			0.0f, this ) )
+	,	m_role( new Qt3DRender::QParameter( QStringLiteral( "growthRole" ),
+			(float) NoGrowth, this ) )
+	,	m_springOffset( new Qt3DRender::QParameter(
+			QStringLiteral( "springOffset" ), QVector3D(), this ) )
+	,	m_turnAge( new Qt3DRender::QParameter( QStringLiteral( "turnAge" ),
+			1.0f, this ) )
+	,	m_autumnIndex( new Qt3DRender::QParameter(
+			QStringLiteral( "autumnIndex" ), 0.0f, this ) )
+	,	m_fallAge( new Qt3DRender::QParameter( QStringLiteral( "fallAge" ),
+			1.0f, this ) )
+{
+	// Same defaults as in QPhongMaterial.
+	addParameter( new Qt3DRender::QParameter( QStringLiteral( "ka" ),
+		QColor::fromRgbF( 0.05f, 0.05f, 0.05f ), this ) );
+	addParameter( new Qt3DRender::QParameter( QStringLiteral( "ks" ),
+		QColor::fromRgbF( 0.01f, 0.01f, 0.01f ), this ) );
+	addParameter( new Qt3DRender::QParameter( QStringLiteral( "shininess" ),
+		150.0f, this ) );
+	addParameter( m_diffuse );
+	addParameter( m_flutter );
+	addParameter( m_birthAge );
+	addParameter( m_length );
+	addParameter( m_role );
+	addParameter( m_springOffset );
+	addParameter( m_turnAge );
+	addParameter( m_autumnIndex );
+	addParameter( m_fallAge );
+
+	setEffect( effect );
+}
+
+TreeMaterial::~TreeMaterial()
+{
+}
+
+QColor
+TreeMaterial::diffuse() const
+{
+	return m_diffuse->value().value< QColor > ();
+}
+
+void
+TreeMaterial::setDiffuse( const QColor & c )
+{
+	m_diffuse->setValue( c );
+}
+
+void
+TreeMaterial::setFlutter( float flutter )
+{
+	m_flutter->setValue( flutter );
+}
+
+void
+TreeMaterial::setGrowth( float birthAge, float length, GrowthRole role )
+{
+	m_birthAge->setValue( birthAge );
+	m_length->setValue( length );
+	m_role->setValue( (float) role );
+}
+
+void
+TreeMaterial::setSpringOffset( const QVector3D & offset )
+{
+	m_springOffset->setValue( offset );
+}
+
+void
+TreeMaterial::setSeason( float turnAge, int autumnIndex, float fallAge )
+{
+	m_turnAge->setValue( turnAge );
+	m_autumnIndex->setValue( (float) autumnIndex );
+	m_fallAge->setValue( fallAge );
+}
@@ -0,0 +1,191 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__TREE_MATERIAL_HPP__INCLUDED
+#define TREE__TREE_MATERIAL_HPP__INCLUDED
+
+// Qt include.
+#include <Qt3DRender/QEffect>
+#include <Qt3DRender/QMaterial>
+#include <Qt3DRender/QGraphicsApiFilter>
+
+QT_BEGIN_NAMESPACE
+
+class QColor;
+class QVector3D;
+
+namespace Qt3DRender {
+	class QParameter;
+	class QTechnique;
+}
+
+QT_END_NAMESPACE
+
+class GrowthPolicy;
+
+
+//! Create forward technique for the given API with one render pass.
+//! Shaders are loaded from qrc:/res/shaders/\par shaders.vert and .frag.
+Qt3DRender::QTechnique * createTechnique(
+	Qt3DRender::QGraphicsApiFilter::Api api,
+	Qt3DRender::QGraphicsApiFilter::OpenGLProfile profile,
+	int major, int minor, const QString & shaders,
+	Qt3DCore::QNode * parent );
+
+
+//
+// TreeEffect
+//
+
+//! Effect shared by all branches and leafs. Holds global uniforms, so
+//! animation of the whole scene costs one parameter update per frame.
+class TreeEffect Q_DECL_FINAL
+	:	public Qt3DRender::QEffect
+{
+public:
+	explicit TreeEffect( Qt3DCore::QNode * parent = Q_NULLPTR );
+	~TreeEffect();
+
+	//! Set time of the wind in seconds.
+	void setTime( float seconds );
+
+	//! Set wind. \par direction is in the ground plane, \par strength
+	//! 0.0 means no wind.
+	void setWind( const QVector3D & direction, float strength );
+
+	//! Set position of the point light.
+	void setLightPosition( const QVector3D & pos );
+
+	//! Set intensity of the point light.
+	void setLightIntensity( float intensity );
+
+	//! Set age of the trees. Growth curves of branches are evaluated in
+	//! the vertex shader from this age.
+	void setAge( float age );
+
+	//! Set growth policy of the trees.
+	void setPolicy( const GrowthPolicy & policy );
+
+private:
+	//! Time.
+	Qt3DRender::QParameter * m_time;
+	//! Wind direction.
+	Qt3DRender::QParameter * m_windDirection;
+	//! Wind strength.
+	Qt3DRender::QParameter * m_windStrength;
+	//! Light position.
+	Qt3DRender::QParameter * m_lightPosition;
+	//! Light intensity.
+	Qt3DRender::QParameter * m_lightIntensity;
+	//! Age of the trees.
+	Qt3DRender::QParameter * m_age;
+	//! Growth policy: branch scale.
+	Qt3DRender::QParameter * m_branchScale;
+	//! Growth policy: branch length multiplicator.
+	Qt3DRender::QParameter * m_branchLengthMultiplicator;
+	//! Growth policy: branch slower.
+	Qt3DRender::QParameter * m_branchSlower;
+	//! Growth policy: first branch grows faster.
+	Qt3DRender::QParameter * m_firstBranchGrowsFaster;
+
+	Q_DISABLE_COPY( TreeEffect )
+}; // class TreeEffect
+
+
+//
+// TreeMaterial
+//
+
+//! Phong material with wind sway. Vertices are bent by the wind in the
+//! vertex shader with amplitude growing with the height above the ground.
+class TreeMaterial Q_DECL_FINAL
+	:	public Qt3DRender::QMaterial
+{
+public:
+	//! Role of the object in the growth.
+	enum GrowthRole {
+		//! Isn't grown by the shader.
+		NoGrowth = 0,
+		//! Branch.
+		BranchGrowth = 1,
+		//! Branch of the trunk, grows faster.
+		TrunkGrowth = 2,
+		//! First branch of the trunk, grows even faster.
+		FirstTrunkGrowth = 3,
+		//! Leaf, grows in the spring, turns color and falls in the autumn.
+		LeafGrowth = 4
+	}; // enum GrowthRole
+
+	explicit TreeMaterial( TreeEffect * effect,
+		Qt3DCore::QNode * parent = Q_NULLPTR );
+	~TreeMaterial();
+
+	//! \return Diffuse color.
+	QColor diffuse() const;
+	//! Set diffuse color.
+	void setDiffuse( const QColor & c );
+
+	//! Set flutter. Object with flutter is swayed as a whole by the wind
+	//! at its origin and flutters around it, as leaf on the stalk.
+	void setFlutter( float flutter );
+
+	//! Set growth of the branch. Transform of the branch should keep state
+	//! at the end of the spring, the shader scales the branch from its
+	//! bottom to the state of the current age. \par birthAge is age of the
+	//! tree when the branch was born, \par length is start length.
+	void setGrowth( float birthAge, float length, GrowthRole role );
+
+	//! Set offset from the position at the end of the spring to the
+	//! position at the start of the spring, in the tree's coordinates.
+	//! The shader moves the object by it during the spring.
+	void setSpringOffset( const QVector3D & offset );
+
+	//! Set seasons of the leaf, ages are counted from the birth of the leaf.
+	//! \par turnAge is age when the leaf turns color, \par autumnIndex is
+	//! index in the autumn palette from 0 (yellow) to 99 (red),
+	//! \par fallAge is age when the leaf falls.
+	void setSeason( float turnAge, int autumnIndex, float fallAge );
+
+private:
+	//! Diffuse color.
+	Qt3DRender::QParameter * m_diffuse;
+	//! Flutter.
+	Qt3DRender::QParameter * m_flutter;
+	//! Birth age.
+	Qt3DRender::QParameter * m_birthAge;
+	//! Start length of the branch.
+	Qt3DRender::QParameter * m_length;
+	//! Growth role.
+	Qt3DRender::QParameter * m_role;
+	//! Spring offset.
+	Qt3DRender::QParameter * m_springOffset;
+	//! Age when the leaf turns color.
+	Qt3DRender::QParameter * m_turnAge;
+	//! Index in the autumn palette.
+	Qt3DRender::QParameter * m_autumnIndex;
+	//! Age when the leaf falls.
+	Qt3DRender::QParameter * m_fallAge;
+
+	Q_DISABLE_COPY( TreeMaterial )
+}; // class TreeMaterial
+
+#endif // TREE__TREE_MATERIAL_HPP__INCLUDED
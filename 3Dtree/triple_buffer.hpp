@@ -0,0 +1,100 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__TRIPLE_BUFFER_HPP__INCLUDED
+#define TREE__TRIPLE_BUFFER_HPP__INCLUDED
+
+// Qt include.
+#include <QtGlobal>
+
+// C++ include.
+#include <atomic>
+
+
+//
+// TripleBuffer
+//
+
+//! Lock-free single producer, single consumer triple buffer. The writer
+//! fills its buffer and publishes it, the reader picks up the latest
+//! published buffer. Neither side waits for the other, buffers published
+//! before the reader picks them up are skipped.
+template< typename T >
+class TripleBuffer Q_DECL_FINAL {
+public:
+	TripleBuffer()
+		:	m_state( 1 )
+		,	m_write( 0 )
+		,	m_read( 2 )
+	{
+	}
+
+	//! \return Buffer of the writer.
+	T & writeBuffer()
+	{
+		return m_buffers[ m_write ];
+	}
+
+	//! Publish buffer of the writer, writer gets the free one.
+	void publish()
+	{
+		m_write = m_state.exchange( m_write | c_fresh,
+			std::memory_order_acq_rel ) & c_index;
+	}
+
+	//! Pick up the latest published buffer.
+	//! \return false if nothing was published since the last call.
+	bool update()
+	{
+		if( !( m_state.load( std::memory_order_relaxed ) & c_fresh ) )
+			return false;
+
+		m_read = m_state.exchange( m_read, std::memory_order_acq_rel ) & c_index;
+
+		return true;
+	}
+
+	//! \return Buffer of the reader.
+	const T & readBuffer() const
+	{
+		return m_buffers[ m_read ];
+	}
+
+private:
+	//! Bits of the index of the shared buffer.
+	static const int c_index = 3;
+	//! Bit of the fresh shared buffer.
+	static const int c_fresh = 4;
+
+	//! Buffers.
+	T m_buffers[ 3 ];
+	//! Index of the shared buffer and the fresh bit.
+	std::atomic< int > m_state;
+	//! Index of the buffer of the writer.
+	int m_write;
+	//! Index of the buffer of the reader.
+	int m_read;
+
+	Q_DISABLE_COPY( TripleBuffer )
+}; // class TripleBuffer
+
+#endif // TREE__TRIPLE_BUFFER_HPP__INCLUDED
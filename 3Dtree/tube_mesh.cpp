@@ -0,0 +1,392 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// 3Dtree include.
+#include "tube_mesh.hpp"
+
+// Qt include.
+#include <Qt3DCore/QGeometry>
+#include <Qt3DCore/QBuffer>
+#include <Qt3DCore/QAttribute>
+
+#include <QtMath>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrentRun>
+
+// C++ include.
+#include <cmath>
+
+
+//! Count of floats per vertex: position and normal.
+static const int c_vertexSize = 6;
+
+
+//
+// TubeGeometry
+//
+
+//! Vertex and index data of the tube, built on the worker thread.
+struct TubeGeometry Q_DECL_FINAL {
+	//! Vertices.
+	QByteArray m_vertices;
+	//! Indices, empty if topology didn't change.
+	QByteArray m_indices;
+	//! Count of vertices.
+	int m_vertexCount;
+	//! Count of indices.
+	int m_indexCount;
+	//! Count of rings.
+	int m_rings;
+	//! Slices.
+	int m_slices;
+}; // struct TubeGeometry
+
+//! Build vertices of the tube.
+static void buildVertices( const QVector< TubeRing > & rings, int slices,
+	TubeGeometry & g )
+{
+	const int ringsCount = ( rings.size() < 2 ? 0 : rings.size() );
+
+	// Rings, then top cap: ring and center.
+	const int count = ( ringsCount > 0 ?
+		ringsCount * slices + slices + 1 : 0 );
+
+	g.m_rings = ringsCount;
+	g.m_slices = slices;
+	g.m_vertexCount = count;
+	g.m_vertices.resize( count * c_vertexSize * sizeof( float ) );
+
+	float * v = reinterpret_cast< float* > ( g.m_vertices.data() );
+
+	auto put = [&v] ( const QVector3D & p, const QVector3D & n )
+	{
+		*v++ = p.x();
+		*v++ = p.y();
+		*v++ = p.z();
+		*v++ = n.x();
+		*v++ = n.y();
+		*v++ = n.z();
+	};
+
+	QVector3D normal;
+	QVector3D tangent;
+
+	for( int i = 0; i < ringsCount; ++i )
+	{
+		// Tangent is the average direction of adjacent segments.
+		const QVector3D & prev = rings.at( i > 0 ? i - 1 : i ).m_center;
+		const QVector3D & next = rings.at( i < ringsCount - 1 ?
+			i + 1 : i ).m_center;
+
+		QVector3D t = ( next - prev ).normalized();
+
+		if( t.isNull() )
+			t = ( tangent.isNull() ? QVector3D( 0.0f, 1.0f, 0.0f ) : tangent );
+
+		// Parallel transport of the frame, so rings don't twist.
+		QVector3D n = normal - t * QVector3D::dotProduct( normal, t );
+
+		if( n.lengthSquared() < 1.0e-6f )
+		{
+			n = QVector3D::crossProduct( t, QVector3D( 1.0f, 0.0f, 0.0f ) );
+
+			if( n.lengthSquared() < 1.0e-6f )
+				n = QVector3D::crossProduct( t, QVector3D( 0.0f, 0.0f, 1.0f ) );
+		}
+
+		n.normalize();
+
+		const QVector3D b = QVector3D::crossProduct( t, n );
+
+		normal = n;
+		tangent = t;
+
+		const TubeRing & r = rings.at( i );
+
+		for( int j = 0; j < slices; ++j )
+		{
+			const float a = 2.0f * (float) M_PI * (float) j / (float) slices;
+			const QVector3D dir = n * std::cos( a ) + b * std::sin( a );
+
+			put( r.m_center + dir * r.m_radius, dir );
+		}
+	}
+
+	if( ringsCount > 0 )
+	{
+		const float * top = reinterpret_cast< const float* > (
+			g.m_vertices.constData() ) + ( ringsCount - 1 ) * slices * c_vertexSize;
+
+		for( int j = 0; j < slices; ++j )
+			put( QVector3D( top[ j * c_vertexSize ], top[ j * c_vertexSize + 1 ],
+				top[ j * c_vertexSize + 2 ] ), tangent );
+
+		put( rings.last().m_center, tangent );
+	}
+}
+
+//! Build indices of the tube.
+static void buildIndices( TubeGeometry & g )
+{
+	const int ringsCount = g.m_rings;
+	const int slices = g.m_slices;
+
+	const int count = ( ringsCount > 0 ?
+		( ( ringsCount - 1 ) * slices * 6 + slices * 3 ) : 0 );
+
+	g.m_indexCount = count;
+	g.m_indices.resize( count * sizeof( quint32 ) );
+
+	quint32 * idx = reinterpret_cast< quint32* > ( g.m_indices.data() );
+
+	for( int i = 0; i < ringsCount - 1; ++i )
+	{
+		const quint32 bottom = i * slices;
+		const quint32 top = bottom + slices;
+
+		for( int j = 0; j < slices; ++j )
+		{
+			const quint32 j1 = ( j + 1 ) % slices;
+
+			*idx++ = bottom + j;
+			*idx++ = bottom + j1;
+			*idx++ = top + j1;
+
+			*idx++ = bottom + j;
+			*idx++ = top + j1;
+			*idx++ = top + j;
+		}
+	}
+
+	if( ringsCount > 0 )
+	{
+		const quint32 cap = ringsCount * slices;
+		const quint32 center = cap + slices;
+
+		for( int j = 0; j < slices; ++j )
+		{
+			*idx++ = center;
+			*idx++ = cap + j;
+			*idx++ = cap + ( j + 1 ) % slices;
+		}
+	}
+}
+
+//! \return Geometry of the tube. Indices are built only if count of rings
+//! or slices differs from the given ones. Called on the worker thread.
+static TubeGeometry buildGeometry( const QVector< TubeRing > & rings,
+	int slices, int indexedRings, int indexedSlices )
+{
+	TubeGeometry g = { QByteArray(), QByteArray(), 0, 0, 0, 0 };
+
+	buildVertices( rings, slices, g );
+
+	if( g.m_rings != indexedRings || g.m_slices != indexedSlices )
+		buildIndices( g );
+
+	return g;
+}
+
+
+//
+// TubeMeshPrivate
+//
+
+class TubeMeshPrivate {
+public:
+	explicit TubeMeshPrivate( TubeMesh * parent )
+		:	m_geometry( Q_NULLPTR )
+		,	m_vertexBuffer( Q_NULLPTR )
+		,	m_indexBuffer( Q_NULLPTR )
+		,	m_position( Q_NULLPTR )
+		,	m_normal( Q_NULLPTR )
+		,	m_index( Q_NULLPTR )
+		,	m_slices( 10 )
+		,	m_indexedSlices( 0 )
+		,	m_indexedRings( 0 )
+		,	m_dirty( false )
+		,	q( parent )
+	{
+	}
+
+	//! Init.
+	void init();
+	//! Build geometry on the worker thread, if a build is running the new
+	//! one starts when it finishes.
+	void build();
+	//! Attach built geometry to the buffers.
+	void attach();
+
+	//! Geometry.
+	Qt3DCore::QGeometry * m_geometry;
+	//! Vertex buffer.
+	Qt3DCore::QBuffer * m_vertexBuffer;
+	//! Index buffer.
+	Qt3DCore::QBuffer * m_indexBuffer;
+	//! Position attribute.
+	Qt3DCore::QAttribute * m_position;
+	//! Normal attribute.
+	Qt3DCore::QAttribute * m_normal;
+	//! Index attribute.
+	Qt3DCore::QAttribute * m_index;
+	//! Rings.
+	QVector< TubeRing > m_rings;
+	//! Slices.
+	int m_slices;
+	//! Slices of the index buffer.
+	int m_indexedSlices;
+	//! Rings of the index buffer.
+	int m_indexedRings;
+	//! Rings or slices changed while the build was running.
+	bool m_dirty;
+	//! Running build.
+	QFutureWatcher< TubeGeometry > m_watcher;
+	//! Parent.
+	TubeMesh * q;
+}; // class TubeMeshPrivate
+
+void
+TubeMeshPrivate::init()
+{
+	m_geometry = new Qt3DCore::QGeometry( q );
+
+	m_vertexBuffer = new Qt3DCore::QBuffer( m_geometry );
+	m_indexBuffer = new Qt3DCore::QBuffer( m_geometry );
+
+	m_position = new Qt3DCore::QAttribute( m_geometry );
+	m_position->setName( Qt3DCore::QAttribute::defaultPositionAttributeName() );
+	m_position->setVertexBaseType( Qt3DCore::QAttribute::Float );
+	m_position->setVertexSize( 3 );
+	m_position->setAttributeType( Qt3DCore::QAttribute::VertexAttribute );
+	m_position->setBuffer( m_vertexBuffer );
+	m_position->setByteStride( c_vertexSize * sizeof( float ) );
+	m_position->setByteOffset( 0 );
+
+	m_normal = new Qt3DCore::QAttribute( m_geometry );
+	m_normal->setName( Qt3DCore::QAttribute::defaultNormalAttributeName() );
+	m_normal->setVertexBaseType( Qt3DCore::QAttribute::Float );
+	m_normal->setVertexSize( 3 );
+	m_normal->setAttributeType( Qt3DCore::QAttribute::VertexAttribute );
+	m_normal->setBuffer( m_vertexBuffer );
+	m_normal->setByteStride( c_vertexSize * sizeof( float ) );
+	m_normal->setByteOffset( 3 * sizeof( float ) );
+
+	m_index = new Qt3DCore::QAttribute( m_geometry );
+	m_index->setVertexBaseType( Qt3DCore::QAttribute::UnsignedInt );
+	m_index->setAttributeType( Qt3DCore::QAttribute::IndexAttribute );
+	m_index->setBuffer( m_indexBuffer );
+
+	m_geometry->addAttribute( m_position );
+	m_geometry->addAttribute( m_normal );
+	m_geometry->addAttribute( m_index );
+
+	q->setGeometry( m_geometry );
+	q->setPrimitiveType( Qt3DRender::QGeometryRenderer::Triangles );
+	q->setVertexCount( 0 );
+
+	QObject::connect( &m_watcher, &QFutureWatcher< TubeGeometry >::finished,
+		q, [this] () { attach(); } );
+}
+
+void
+TubeMeshPrivate::build()
+{
+	if( m_watcher.isRunning() )
+	{
+		m_dirty = true;
+
+		return;
+	}
+
+	m_dirty = false;
+
+	// Rings are implicitly shared, the worker reads its own copy.
+	m_watcher.setFuture( QtConcurrent::run( buildGeometry, m_rings, m_slices,
+		m_indexedRings, m_indexedSlices ) );
+}
+
+void
+TubeMeshPrivate::attach()
+{
+	const TubeGeometry g = m_watcher.result();
+
+	m_vertexBuffer->setData( g.m_vertices );
+	m_position->setCount( g.m_vertexCount );
+	m_normal->setCount( g.m_vertexCount );
+
+	if( g.m_rings != m_indexedRings || g.m_slices != m_indexedSlices )
+	{
+		m_indexedRings = g.m_rings;
+		m_indexedSlices = g.m_slices;
+
+		m_indexBuffer->setData( g.m_indices );
+		m_index->setCount( g.m_indexCount );
+		q->setVertexCount( g.m_indexCount );
+	}
+
+	// Only the latest rings are built, intermediate ones are skipped.
+	if( m_dirty )
+		build();
+}
+
+
+//
+// TubeMesh
+//
+
+TubeMesh::TubeMesh( Qt3DCore::QNode * parent )
+	:	Qt3DRender::QGeometryRenderer( parent )
+	,	d( new TubeMeshPrivate( this ) )
+{
+	d->init();
+}
+
+TubeMesh::~TubeMesh()
+{
+}
+
+int
+TubeMesh::slices() const
+{
+	return d->m_slices;
+}
+
+void
+TubeMesh::setSlices( int slices )
+{
+	slices = qMax( 3, slices );
+
+	if( slices == d->m_slices )
+		return;
+
+	d->m_slices = slices;
+
+	d->build();
+}
+
+void
+TubeMesh::setRings( const QVector< TubeRing > & rings )
+{
+	d->m_rings = rings;
+
+	d->build();
+}
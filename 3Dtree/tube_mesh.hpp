@@ -0,0 +1,84 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2017 Igor Mironchik
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TREE__TUBE_MESH_HPP__INCLUDED
+#define TREE__TUBE_MESH_HPP__INCLUDED
+
+// Qt include.
+#include <Qt3DRender/QGeometryRenderer>
+#include <QVector3D>
+#include <QVector>
+
+// C++ include.
+#include <memory>
+
+
+//
+// TubeRing
+//
+
+//! Ring of the tube.
+struct TubeRing Q_DECL_FINAL {
+	//! Center.
+	QVector3D m_center;
+	//! Radius.
+	float m_radius;
+}; // struct TubeRing
+
+
+//
+// TubeMesh
+//
+
+class TubeMeshPrivate;
+
+//! Generalized cylinder swept along rings. Adjacent segments share
+//! rings, there are no interior caps, only the top one.
+//!
+//! Vertices and indices are built on the worker thread and attached to
+//! the buffers on the main thread when they are ready, so the mesh shows
+//! the previous rings till then.
+class TubeMesh Q_DECL_FINAL
+	:	public Qt3DRender::QGeometryRenderer
+{
+public:
+	explicit TubeMesh( Qt3DCore::QNode * parent = Q_NULLPTR );
+	~TubeMesh();
+
+	//! \return Count of vertices around the ring.
+	int slices() const;
+	//! Set count of vertices around the ring.
+	void setSlices( int slices );
+
+	//! Set rings, from the bottom to the top. At least two rings are
+	//! needed to build the tube.
+	void setRings( const QVector< TubeRing > & rings );
+
+private:
+	friend class TubeMeshPrivate;
+
+	Q_DISABLE_COPY( TubeMesh )
+
+	std::unique_ptr< TubeMeshPrivate > d;
+}; // class TubeMesh
+
+#endif // TREE__TUBE_MESH_HPP__INCLUDED